@@ -1,14 +1,31 @@
 // Copyright (C) 2025 Moshe Sulamy
 
 #pragma once
+#include <cassert>
 #include <cstdlib>
+#include <cstddef>
 #include <cstdint>
 #include <cstring>
 #include <type_traits>
 #include <algorithm>
+#include <new>
+#include <memory>
+#include <utility>
+#include <atomic>
+#include <functional>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+
+#if __has_include(<sys/mman.h>)
+	#include <sys/mman.h>
+	#define BAGEL_HAS_MMAP
+#endif
 
 namespace bagel
 {
+	enum class Allocation { Heap, Arena, Pool, HugePage };
+
 	struct Bagel
 	{
 		bool	DynamicResize = false;
@@ -16,12 +33,17 @@ namespace bagel
 		int		InitialEntities = 30;
 		int		InitialPackedSize = 5;
 		int		MaxComponents = 10;
+		int		InitialQueries = 10;
+		int		ChunkSize = 64;
+		Allocation	Allocator = Allocation::Heap;
+		int		ArenaBlockSize = 1<<20;
 	};
 
 	template <class T> struct Storage;
 	template <class T> class PackedStorage;
 	template <class T> class SparseStorage;
 	template <class T> class TaggedStorage;
+	template <class T> class ArchetypeStorage;
 
 #if __has_include("bagel_cfg.h")
 	#define BAGEL_STORAGE(C,T) template <> struct Storage<C> { using type = T<C>; };
@@ -32,9 +54,33 @@ namespace bagel
 #endif
 
 	using id_type = int;
-	struct ent_type { id_type id; };
+	using version_type = std::uint32_t;
+
+	// Handles pack into pointer-sized user data: 32 bits of id and 32 of version on 64-bit
+	// targets, 20 and 12 on 32-bit ones. Versions wrap at what fits, so a round trip is exact.
+	constexpr inline int			UserDataIdBits = sizeof(std::uintptr_t) >= 8 ? 32 : 20;
+	constexpr inline std::uintptr_t	UserDataIdMask = (std::uintptr_t{1} << UserDataIdBits) - 1;
+	constexpr inline version_type	MaxVersion =
+		static_cast<version_type>(~std::uintptr_t{0} >> UserDataIdBits);
+
+	struct ent_type
+	{
+		id_type			id;
+		version_type	version = 1;
+
+		void* toUserData() const {
+			assert(static_cast<std::uintptr_t>(id) <= UserDataIdMask && "Id too large for user data");
+			return reinterpret_cast<void*>(
+				static_cast<std::uintptr_t>(version) << UserDataIdBits | static_cast<std::uintptr_t>(id));
+		}
+		static ent_type fromUserData(const void* p) {
+			const auto bits = reinterpret_cast<std::uintptr_t>(p);
+			return {static_cast<id_type>(bits & UserDataIdMask), static_cast<version_type>(bits >> UserDataIdBits)};
+		}
+	};
 	using size_type = int;
 	using index_type = int;
+	using tick_type = std::uint32_t;
 	using mask_type =
 		std::conditional_t<Params.MaxComponents<=8, std::uint_fast8_t,
 		std::conditional_t<Params.MaxComponents<=16, std::uint_fast16_t,
@@ -49,37 +95,209 @@ namespace bagel
 		void operator=(const NoCopy&) = delete;
 	};
 
-	template <class T, int N>
+	class HeapAllocator final : NoInstance
+	{
+	public:
+		static void* allocate(std::size_t bytes, std::size_t align) {
+			return ::operator new(bytes, std::align_val_t{align});
+		}
+		static void deallocate(void* p, std::size_t, std::size_t align) {
+			::operator delete(p, std::align_val_t{align});
+		}
+	};
+	// One arena and one set of free lists per process, shared by every thread: a bag
+	// may be created on one thread and grown or destroyed on another
+	class ArenaAllocator final : NoInstance
+	{
+	public:
+		static void* allocate(std::size_t bytes, std::size_t align) {
+			std::lock_guard<std::mutex> lock(_mutex);
+			std::uintptr_t at = (_next + align - 1) & ~(align - 1);
+			if (_next == 0 || at + bytes > _end) {
+				const std::size_t size = std::max<std::size_t>(Params.ArenaBlockSize, sizeof(Block) + bytes + align);
+				_head = new (HeapAllocator::allocate(size, alignof(std::max_align_t))) Block{_head, size};
+				rewind();
+				at = (_next + align - 1) & ~(align - 1);
+			}
+			_next = at + bytes;
+			return reinterpret_cast<void*>(at);
+		}
+		// Memory comes back only through reset(), so a bag that outgrows its reserve
+		// leaves each old array behind. Reserve up front (World::reserve) and reset
+		// between matches.
+		static void deallocate(void*, std::size_t, std::size_t) {}
+
+		// Reclaims everything the arena handed out, keeping its first block for reuse.
+		// Only once nothing allocated from it is alive, e.g. after the match's World is gone.
+		static void reset() {
+			std::lock_guard<std::mutex> lock(_mutex);
+			while (_head && _head->prev) {
+				Block* const prev = _head->prev;
+				HeapAllocator::deallocate(_head, _head->size, alignof(std::max_align_t));
+				_head = prev;
+			}
+			if (_head)
+				rewind();
+		}
+	private:
+		struct alignas(std::max_align_t) Block {
+			Block*		prev;
+			std::size_t	size;
+		};
+		static void rewind() {
+			_next = reinterpret_cast<std::uintptr_t>(_head + 1);
+			_end = reinterpret_cast<std::uintptr_t>(_head) + _head->size;
+		}
+
+		static inline std::mutex		_mutex;
+		static inline Block*			_head = nullptr;
+		static inline std::uintptr_t	_next = 0;
+		static inline std::uintptr_t	_end = 0;
+	};
+	class PoolAllocator final : NoInstance
+	{
+	public:
+		// Free lists are kept per size and alignment, so a block is only reused for a request
+		// it was allocated to satisfy. Alignments past MaxAlign go straight to the heap.
+		static void* allocate(std::size_t bytes, std::size_t align) {
+			if (align > MaxAlign)
+				return HeapAllocator::allocate(bytes, align);
+			const int c = sizeClass(std::max(bytes, align));
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+				Block*& free = _free[c][alignClass(align)];
+				if (Block* b = free) {
+					free = b->next;
+					return b;
+				}
+			}
+			return HeapAllocator::allocate(std::size_t{1} << c, std::max(align, MinBlock));
+		}
+		static void deallocate(void* p, std::size_t bytes, std::size_t align) {
+			if (align > MaxAlign)
+				return HeapAllocator::deallocate(p, bytes, align);
+			std::lock_guard<std::mutex> lock(_mutex);
+			Block*& free = _free[sizeClass(std::max(bytes, align))][alignClass(align)];
+			free = new (p) Block{free};
+		}
+	private:
+		struct Block { Block* next; };
+		static constexpr std::size_t MinBlock = 16;
+		static constexpr std::size_t MaxAlign = 4096;
+		static constexpr int Classes = sizeof(std::size_t)*8;
+		static constexpr int AlignClasses = 9; // MinBlock up to MaxAlign
+
+		static int sizeClass(std::size_t bytes) {
+			int c = 4;
+			while ((std::size_t{1} << c) < bytes)
+				++c;
+			return c;
+		}
+		static int alignClass(std::size_t align) {
+			int c = 0;
+			while ((MinBlock << c) < align)
+				++c;
+			return c;
+		}
+		static inline std::mutex	_mutex;
+		static inline Block*		_free[Classes][AlignClasses] = {};
+	};
+	class HugePageAllocator final : NoInstance
+	{
+	public:
+		// Only bags that fill at least half a huge page get one; smaller ones would pin
+		// 2 MB each, so they come from the heap
+		static void* allocate(std::size_t bytes, std::size_t align) {
+#ifdef BAGEL_HAS_MMAP
+			if (bytes < MinBytes)
+				return HeapAllocator::allocate(bytes, align);
+			const std::size_t size = pages(bytes);
+			void* p = MAP_FAILED;
+	#ifdef MAP_HUGETLB
+			p = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS|MAP_HUGETLB, -1, 0);
+	#endif
+			if (p == MAP_FAILED) {
+				p = mmap(nullptr, size, PROT_READ|PROT_WRITE, MAP_PRIVATE|MAP_ANONYMOUS, -1, 0);
+				if (p == MAP_FAILED)
+					throw std::bad_alloc();
+	#ifdef MADV_HUGEPAGE
+				madvise(p, size, MADV_HUGEPAGE);
+	#endif
+			}
+			return p;
+#else
+			return HeapAllocator::allocate(bytes, align);
+#endif
+		}
+		static void deallocate(void* p, std::size_t bytes, std::size_t align) {
+#ifdef BAGEL_HAS_MMAP
+			if (bytes < MinBytes)
+				return HeapAllocator::deallocate(p, bytes, align);
+			munmap(p, pages(bytes));
+#else
+			HeapAllocator::deallocate(p, bytes, align);
+#endif
+		}
+	private:
+		static constexpr std::size_t PageSize = std::size_t{2} << 20;
+		static constexpr std::size_t MinBytes = PageSize / 2;
+		static std::size_t pages(std::size_t bytes) {
+			return (bytes + PageSize - 1) / PageSize * PageSize;
+		}
+	};
+	using DefaultAllocator =
+		std::conditional_t<Params.Allocator==Allocation::Arena, ArenaAllocator,
+		std::conditional_t<Params.Allocator==Allocation::Pool, PoolAllocator,
+		std::conditional_t<Params.Allocator==Allocation::HugePage, HugePageAllocator,
+			HeapAllocator>>>;
+
+	template <class T, int N, class A = DefaultAllocator>
 	class DynamicBag : NoCopy
 	{
 	public:
+		DynamicBag() : _arr(make(N)) {}
+		~DynamicBag() { release(_arr, _capacity); }
+
 		void push(const T& t) {
-			if (_size == _capacity) {
-				_capacity *= 2;
-				_arr = static_cast<T*>(
-					realloc(_arr, sizeof(T)*_capacity));
-			}
+			if (_size == _capacity)
+				grow(_capacity*2);
 			_arr[_size] = t;
 			++_size;
 		}
 		void ensure(size_type s) {
-			if (_capacity < s) {
-				_capacity = std::max(s, _capacity*2);
-				_arr = static_cast<T*>(
-					realloc(_arr, sizeof(T)*_capacity));
-			}
+			if (_capacity < s)
+				grow(std::max(s, _capacity*2));
 		}
 		T pop() { return _arr[--_size]; }
 		T& operator[](index_type i) { return _arr[i]; }
 		const T& operator[](index_type i) const { return _arr[i]; }
 		void clear() { _size = 0; }
 
+		const T* begin() const { return _arr; }
+		const T* end() const { return _arr + _size; }
+
 		size_type size() const { return _size; }
 		size_type capacity() const { return _capacity; }
-
-		~DynamicBag() { free(_arr); }
 	private:
-		T*			_arr = static_cast<T*>(malloc(sizeof(T) * N));
+		static T* make(size_type n) {
+			T* arr = static_cast<T*>(A::allocate(sizeof(T)*n, alignof(T)));
+			std::uninitialized_value_construct_n(arr, n);
+			return arr;
+		}
+		static void release(T* arr, size_type n) {
+			std::destroy_n(arr, n);
+			A::deallocate(arr, sizeof(T)*n, alignof(T));
+		}
+		void grow(size_type capacity) {
+			T* arr = static_cast<T*>(A::allocate(sizeof(T)*capacity, alignof(T)));
+			std::uninitialized_move_n(_arr, _capacity, arr);
+			std::uninitialized_value_construct_n(arr + _capacity, capacity - _capacity);
+			release(_arr, _capacity);
+			_arr = arr;
+			_capacity = capacity;
+		}
+
+		T*			_arr;
 		size_type	_size = 0;
 		size_type	_capacity = N;
 	};
@@ -93,39 +311,43 @@ namespace bagel
 		const T& operator[](index_type i) const { return _arr[i]; }
 		void clear() { _size = 0; }
 
+		const T* begin() const { return _arr; }
+		const T* end() const { return _arr + _size; }
+
 		size_type size() const { return _size; }
 		static void ensure(size_type) {}
 	private:
 		T			_arr[N];
 		size_type	_size = 0;
 	};
-	template <class T, int N>
-	using Bag = std::conditional_t<Params.DynamicResize, DynamicBag<T, N>, StaticBag<T,N>>;
+	template <class T, int N, class A = DefaultAllocator>
+	using Bag = std::conditional_t<Params.DynamicResize, DynamicBag<T,N,A>, StaticBag<T,N>>;
 
 	template <class T>
-	class SparseStorage final : NoInstance
+	class SparseStorage final : NoCopy
 	{
 	public:
-		static void add(ent_type e, const T& t) {
-			_bag.ensure(e.id);
+		void add(ent_type e, const T& t) {
+			_bag.ensure(e.id+1);
 			_bag[e.id] = t;
 		}
-		static void del(ent_type) {}
-		static T& get(ent_type e) { return _bag[e.id]; }
+		void del(ent_type) {}
+		T& get(ent_type e) { return _bag[e.id]; }
+		void reserve(size_type entities, size_type) { _bag.ensure(entities); }
 	private:
-		static inline Bag<T,Params.InitialEntities> _bag;
+		Bag<T,Params.InitialEntities> _bag;
 	};
 	template <class T>
-	class PackedStorage final : NoInstance
+	class PackedStorage final : NoCopy
 	{
 	public:
-		static void add(ent_type e, const T& t) {
-			_entToComp.ensure(e.id);
+		void add(ent_type e, const T& t) {
+			_entToComp.ensure(e.id+1);
 			_entToComp[e.id] = _comps.size();
 			_comps.push(t);
 			_compToEnt.push(e);
 		}
-		static void del(ent_type e) {
+		void del(ent_type e) {
 			index_type ent_comp_idx = _entToComp[e.id];
 			ent_type last_ent = _compToEnt.pop();
 
@@ -133,28 +355,34 @@ namespace bagel
 			_compToEnt[ent_comp_idx] = last_ent;
 			_entToComp[last_ent.id] = ent_comp_idx;
 		}
-		static T& get(ent_type e) {
+		T& get(ent_type e) {
 			return _comps[_entToComp[e.id]];
 		}
-		static int size() { return _comps.size(); }
-		static T& get(index_type idx) {
+		int size() const { return _comps.size(); }
+		T& get(index_type idx) {
 			return _comps[idx];
 		}
-		static ent_type entity(index_type idx) {
+		ent_type entity(index_type idx) const {
 			return _compToEnt[idx];
 		}
+		void reserve(size_type entities, size_type count) {
+			_entToComp.ensure(entities);
+			_comps.ensure(count);
+			_compToEnt.ensure(count);
+		}
 	private:
-		static inline Bag<T,Params.InitialPackedSize>			_comps;
-		static inline Bag<index_type,Params.InitialEntities>	_entToComp;
-		static inline Bag<ent_type,Params.InitialPackedSize>	_compToEnt;
+		Bag<T,Params.InitialPackedSize>			_comps;
+		Bag<index_type,Params.InitialEntities>	_entToComp;
+		Bag<ent_type,Params.InitialPackedSize>	_compToEnt;
 	};
 	template <class T>
-	class TaggedStorage final : NoInstance
+	class TaggedStorage final : NoCopy
 	{
 	public:
-		static void add(ent_type, const T&) {}
-		static void del(ent_type) {}
-		static T& get(ent_type) = delete;
+		void add(ent_type, const T&) {}
+		void del(ent_type) {}
+		T& get(ent_type) = delete;
+		void reserve(size_type, size_type) {}
 	};
 
 	template <class T>
@@ -166,7 +394,7 @@ namespace bagel
 	{
 	public:
 		using bit_type = mask_type;
-		static constexpr bit_type bit(index_type idx) { return 1<<idx; }
+		static constexpr bit_type bit(index_type idx) { return static_cast<bit_type>(1)<<idx; }
 
 		void set(const bit_type b) { _mask |= b; }
 
@@ -175,10 +403,14 @@ namespace bagel
 
 		bool test(const bit_type b) const { return _mask & b; }
 		bool test(const SingleMask m) const { return (_mask & m._mask) == m._mask; }
+
+		bool operator==(const SingleMask m) const { return _mask == m._mask; }
 	private:
 		mask_type	_mask{0};
 	};
-	class MultiMask final
+	// Sized for Params.MaxComponents; other widths are there for benchmarking
+	template <int Components>
+	class BasicMultiMask final
 	{
 	public:
 		using bit_type = struct {
@@ -186,7 +418,7 @@ namespace bagel
 			const mask_type		mask;
 		};
 		static constexpr bit_type bit(index_type idx) {
-			return {idx/BitsetWidth, static_cast<mask_type>(1<<(idx%BitsetWidth))};
+			return {idx/BitsetWidth, static_cast<mask_type>(static_cast<mask_type>(1)<<(idx%BitsetWidth))};
 		}
 
 		void set(const bit_type& b) { _masks[b.index] |= b.mask; }
@@ -195,53 +427,496 @@ namespace bagel
 		void clear() { memset(_masks, 0, sizeof(_masks)); }
 
 		bool test(const bit_type& b) const { return _masks[b.index] & b.mask; }
-		bool test(const MultiMask& m) const {
+		bool test(const BasicMultiMask& m) const {
 			for (index_type i = 0; i < Size; ++i)
 				if ((_masks[i] & m._masks[i]) != m._masks[i])
 					return false;
 			return true;
 		}
+
+		bool operator==(const BasicMultiMask& m) const {
+			return memcmp(_masks, m._masks, sizeof(_masks)) == 0;
+		}
 	private:
-		static constexpr size_type	Size = (Params.MaxComponents-1)/BitsetWidth + 1;
+		static constexpr size_type	Size = (Components-1)/BitsetWidth + 1;
 		mask_type					_masks[Size] ={};
 	};
+	using MultiMask = BasicMultiMask<Params.MaxComponents>;
 	using Mask = std::conditional_t<Params.MaxComponents<=BitsetWidth, SingleMask, MultiMask>;
 
-	static inline index_type compCounter = -1;
-	template <class>
+	class Archetypes;
+
+	// Type-erased entry points into a world's storage for one component
+	struct StorageOps
+	{
+		void*	(*create)(Archetypes&);
+		void	(*destroy)(void*);
+		void	(*del)(void*, ent_type);
+		void	(*reserve)(void*, size_type entities, size_type count);
+	};
+	template <class S>
+	struct StorageOpsOf final : NoInstance
+	{
+		static void* create(Archetypes& a) {
+			if constexpr (std::is_constructible_v<S, Archetypes&>)
+				return new S(a);
+			else
+				return new S;
+		}
+		static void destroy(void* s) { delete static_cast<S*>(s); }
+		static void del(void* s, ent_type e) { static_cast<S*>(s)->del(e); }
+		static void reserve(void* s, size_type entities, size_type count) {
+			static_cast<S*>(s)->reserve(entities, count);
+		}
+		static constexpr StorageOps Ops{&create, &destroy, &del, &reserve};
+	};
+
+	// Shared by every translation unit, like the Component<T>::Index values they hand out
+	inline index_type	compCounter = -1;
+	inline StorageOps	compOps[Params.MaxComponents] = {};
+
+	inline index_type registerComponent(const StorageOps& ops) {
+		assert(compCounter + 1 < Params.MaxComponents && "More components than Params.MaxComponents");
+		++compCounter;
+		compOps[compCounter] = ops;
+		return compCounter;
+	}
+
+	// A component opts into change tracking with `static constexpr bool TrackChanges = true;`
+	template <class T, class = void>
+	struct Tracked : std::false_type {};
+	template <class T>
+	struct Tracked<T, std::enable_if_t<T::TrackChanges>> : std::true_type {};
+
+	template <class T>
 	struct Component final : NoInstance
 	{
-		static inline const index_type		Index = ++compCounter;
+		static inline const index_type		Index =
+			registerComponent(StorageOpsOf<typename Storage<T>::type>::Ops);
 		static inline const Mask::bit_type	Bit = Mask::bit(Index);
 	};
 
-	class World final : NoInstance
+	class Archetypes final : NoCopy
 	{
 	public:
+		using move_fn = void(*)(void* dst, void* src);
+		using destroy_fn = void(*)(void*);
+
+		Archetypes() { _archetypes.push(new Archetype(Mask{}, _columns)); }
+
+		void column(index_type comp, size_type size, size_type align,
+					move_fn move, destroy_fn destroy) {
+			_columns[comp] = {size, align, move, destroy};
+		}
+
+		void* insert(ent_type e, index_type comp) {
+			const Location from = locate(e);
+			Archetype& a = *_archetypes[from.archetype];
+			if (a.offset[comp] != -1) {
+				_columns[comp].destroy(a.at(from.row, comp));
+				return a.at(from.row, comp);
+			}
+			return migrate(e, from, edge(from.archetype, comp, true), comp);
+		}
+		void erase(ent_type e, index_type comp) {
+			const Location from = locate(e);
+			Archetype& a = *_archetypes[from.archetype];
+			if (a.offset[comp] == -1)
+				return;
+			_columns[comp].destroy(a.at(from.row, comp));
+			migrate(e, from, edge(from.archetype, comp, false), comp);
+		}
+		void* get(ent_type e, index_type comp) {
+			const Location& loc = _locations[e.id];
+			return _archetypes[loc.archetype]->at(loc.row, comp);
+		}
+		void reserve(size_type entities) {
+			if (entities > 0)
+				locate({entities-1});
+		}
+
+		template <class ...Ts, class F>
+		void each(F&& f) {
+			Mask m;
+			(m.set(Component<Ts>::Bit), ...);
+			for (index_type i = 1; i < _archetypes.size(); ++i) {
+				Archetype& a = *_archetypes[i];
+				if (!a.mask.test(m))
+					continue;
+				for (index_type c = 0; c*Params.ChunkSize < a.count; ++c) {
+					unsigned char* chunk = a.chunks[c];
+					const auto* ents = reinterpret_cast<const ent_type*>(chunk);
+					const size_type n = std::min(Params.ChunkSize, a.count - c*Params.ChunkSize);
+					for (index_type r = 0; r < n; ++r)
+						f(ents[r], reinterpret_cast<Ts*>(chunk + a.offset[Component<Ts>::Index])[r]...);
+				}
+			}
+		}
+	private:
+		struct Column {
+			size_type	size, align;
+			move_fn		move;
+			destroy_fn	destroy;
+		};
+		struct Location {
+			index_type	archetype;
+			index_type	row;
+		};
+		struct Archetype : NoCopy
+		{
+			Mask			mask;
+			const Column*	columns;
+			size_type		count = 0;
+			size_type		bytes = 0;
+			index_type		offset[Params.MaxComponents];
+			index_type		next[Params.MaxComponents];
+			index_type		prev[Params.MaxComponents];
+			Bag<unsigned char*,Params.InitialPackedSize> chunks;
+
+			Archetype(const Mask& m, const Column* cols) : mask(m), columns(cols) {
+				std::fill_n(offset, Params.MaxComponents, -1);
+				std::fill_n(next, Params.MaxComponents, -1);
+				std::fill_n(prev, Params.MaxComponents, -1);
+
+				bytes = Params.ChunkSize * sizeof(ent_type);
+				for (index_type i = 0; i <= compCounter; ++i) {
+					if (!m.test(Mask::bit(i)))
+						continue;
+					bytes = (bytes + columns[i].align - 1) / columns[i].align * columns[i].align;
+					offset[i] = bytes;
+					bytes += Params.ChunkSize * columns[i].size;
+				}
+			}
+			~Archetype() {
+				for (index_type row = 0; row < count; ++row)
+					for (index_type i = 0; i <= compCounter; ++i)
+						if (offset[i] != -1)
+							columns[i].destroy(at(row, i));
+				for (unsigned char* c : chunks)
+					DefaultAllocator::deallocate(c, bytes, ChunkAlign);
+			}
+
+			ent_type& entity(index_type row) {
+				return reinterpret_cast<ent_type*>(chunks[row/Params.ChunkSize])[row%Params.ChunkSize];
+			}
+			void* at(index_type row, index_type comp) {
+				return chunks[row/Params.ChunkSize] + offset[comp]
+					+ (row%Params.ChunkSize) * columns[comp].size;
+			}
+			index_type push(ent_type e) {
+				if (count == chunks.size()*Params.ChunkSize)
+					chunks.push(static_cast<unsigned char*>(
+						DefaultAllocator::allocate(bytes, ChunkAlign)));
+				entity(count) = e;
+				return count++;
+			}
+			void release() {
+				if ((count % Params.ChunkSize) == 0 && chunks.size() > count / Params.ChunkSize)
+					DefaultAllocator::deallocate(chunks.pop(), bytes, ChunkAlign);
+			}
+		};
+		struct ArchetypeBag : Bag<Archetype*,Params.InitialPackedSize> {
+			~ArchetypeBag() { for (const Archetype* a : *this) delete a; }
+		};
+
+		static constexpr std::size_t ChunkAlign = 64;
+
+		Location locate(ent_type e) {
+			_locations.ensure(e.id+1);
+			while (_known <= e.id)
+				_locations[_known++] = Location{0, -1};
+			return _locations[e.id];
+		}
+
+		index_type edge(index_type from, index_type comp, bool add) {
+			index_type& cached = add ? _archetypes[from]->next[comp] : _archetypes[from]->prev[comp];
+			if (cached != -1)
+				return cached;
+
+			Mask m = _archetypes[from]->mask;
+			if (add) m.set(Mask::bit(comp));
+			else m.clear(Mask::bit(comp));
+
+			index_type to = 0;
+			while (to < _archetypes.size() && !(_archetypes[to]->mask == m))
+				++to;
+			if (to == _archetypes.size())
+				_archetypes.push(new Archetype(m, _columns));
+
+			(add ? _archetypes[to]->prev : _archetypes[to]->next)[comp] = from;
+			return cached = to;
+		}
+
+		void* migrate(ent_type e, Location from, index_type to, index_type comp) {
+			Archetype& dst = *_archetypes[to];
+			Location loc{to, -1};
+			if (to != 0) {
+				loc.row = dst.push(e);
+				for (index_type i = 0; i <= compCounter; ++i)
+					if (i != comp && dst.offset[i] != -1)
+						_columns[i].move(dst.at(loc.row, i),
+							_archetypes[from.archetype]->at(from.row, i));
+			}
+			_locations[e.id] = loc;
+
+			if (from.archetype != 0) {
+				Archetype& src = *_archetypes[from.archetype];
+				const index_type last = src.count - 1;
+				if (from.row != last) {
+					const ent_type moved = src.entity(last);
+					for (index_type i = 0; i <= compCounter; ++i)
+						if (src.offset[i] != -1)
+							_columns[i].move(src.at(from.row, i), src.at(last, i));
+					src.entity(from.row) = moved;
+					_locations[moved.id].row = from.row;
+				}
+				--src.count;
+				src.release();
+			}
+			return to != 0 && dst.offset[comp] != -1 ? dst.at(loc.row, comp) : nullptr;
+		}
+
+		Column								_columns[Params.MaxComponents];
+		ArchetypeBag						_archetypes;
+		Bag<Location,Params.InitialEntities>	_locations;
+		size_type							_known = 0;
+	};
+
+	template <class T>
+	class ArchetypeStorage final : NoCopy
+	{
+	public:
+		explicit ArchetypeStorage(Archetypes& a) : _archetypes(a) {
+			a.column(Component<T>::Index, sizeof(T), alignof(T), &move, &destroy);
+		}
+		void add(ent_type e, const T& t) {
+			new (_archetypes.insert(e, Component<T>::Index)) T(t);
+		}
+		void del(ent_type e) { _archetypes.erase(e, Component<T>::Index); }
+		T& get(ent_type e) {
+			return *static_cast<T*>(_archetypes.get(e, Component<T>::Index));
+		}
+		void reserve(size_type entities, size_type) { _archetypes.reserve(entities); }
+	private:
+		static void move(void* dst, void* src) {
+			new (dst) T(std::move(*static_cast<T*>(src)));
+			static_cast<T*>(src)->~T();
+		}
+		static void destroy(void* p) { static_cast<T*>(p)->~T(); }
+
+		Archetypes& _archetypes;
+	};
+
+	class Query final : NoCopy
+	{
+	public:
+		explicit Query(const Mask& m) : _mask(m) {}
+		const Mask& mask() const { return _mask; }
+
+		void update(ent_type e, const Mask& prev, const Mask& curr) {
+			const bool had = prev.test(_mask), has = curr.test(_mask);
+			if (!had && has)
+				insert(e);
+			else if (had && !has)
+				remove(e);
+		}
+		void insert(ent_type e) {
+			_index.ensure(e.id+1);
+			_index[e.id] = _ents.size();
+			_ents.push(e);
+		}
+		void remove(ent_type e) {
+			const index_type idx = _index[e.id];
+			const ent_type last = _ents.pop();
+			if (idx < _ents.size()) {
+				_ents[idx] = last;
+				_index[last.id] = idx;
+			}
+		}
+
+		void reserve(size_type entities) {
+			_ents.ensure(entities);
+			_index.ensure(entities);
+		}
+
+		size_type size() const { return _ents.size(); }
+		ent_type operator[](index_type i) const { return _ents[i]; }
+		const ent_type* begin() const { return _ents.begin(); }
+		const ent_type* end() const { return _ents.end(); }
+	private:
+		friend class World;
+
+		Mask									_mask;
+		Bag<ent_type,Params.InitialEntities>	_ents;
+		Bag<index_type,Params.InitialEntities>	_index;
+		const Query*							_next = nullptr; // World's lookup list
+	};
+
+	class CommandBuffer;
+
+	class World final : NoCopy
+	{
+	public:
+		World() = default;
+		~World();
+
+		// Binds a world as the current one for this thread until the scope ends
+		class Scope final : NoCopy
+		{
+		public:
+			explicit Scope(World& w) : _prev(_current) { _current = &w; }
+			~Scope() { _current = _prev; }
+		private:
+			World* _prev;
+		};
+
+		// The world the static API operates on: the innermost Scope, else the default world
+		static World& current() {
+			if (_current)
+				return *_current;
+			static World world;
+			return world;
+		}
+
 		static ent_type createEntity() {
-			if (_ids.size() > 0)
-				return _ids.pop();
-			_masks.push(Mask{});
-			return {++_maxId.id};
+			World& w = current();
+			if (w._ids.size() > 0) {
+				const id_type id = w._ids.pop().id;
+				return {id, w._versions[id]};
+			}
+			w._masks.push(Mask{});
+			w._versions.push(1);
+			return {++w._maxId.id, 1};
 		}
 		static void destroyEntity(ent_type ent) {
-			_masks[ent.id].clear();
-			_ids.push(ent);
+			World& w = current();
+			if (!alive(ent))
+				return;
+			const Mask prev = w._masks[ent.id];
+			for (index_type i = 0; i <= compCounter; ++i)
+				if (prev.test(Mask::bit(i)))
+					compOps[i].del(w._pools[i], ent);
+			w._masks[ent.id].clear();
+			w.updateQueries(ent, prev);
+			version_type& version = w._versions[ent.id];
+			version = (version == MaxVersion) ? 1 : version + 1;
+			w._ids.push(ent);
+		}
+		static bool alive(ent_type e) {
+			const World& w = current();
+			return e.id >= 0 && e.id <= w._maxId.id && w._versions[e.id] == e.version;
+		}
+
+		static void reserve(size_type entities, size_type perComponent) {
+			World& w = current();
+			w._reserved = std::max(w._reserved, entities);
+			w._masks.ensure(entities);
+			w._versions.ensure(entities);
+			w._ids.ensure(entities);
+			for (index_type i = 0; i < w._queries.size(); ++i)
+				w._queries[i]->reserve(entities);
+			for (index_type i = 0; i <= compCounter; ++i)
+				compOps[i].reserve(w.pool(i), entities, perComponent);
 		}
 		static const Mask& mask(ent_type e) {
-			return _masks[e.id];
+			return current()._masks[e.id];
+		}
+		static ent_type maxId() { return current()._maxId; }
+
+		// Finding an existing query takes no lock: queries are never removed, and new
+		// ones are published at the head of a list that readers walk. Only building a
+		// query locks, and it looks again under the lock in case another thread won.
+		static const Query& query(const Mask& m) {
+			World& w = current();
+			if (const Query* q = find(w._queryList.load(std::memory_order_acquire), m))
+				return *q;
+
+			std::lock_guard<std::mutex> lock(w._queryMutex);
+			const Query* const head = w._queryList.load(std::memory_order_relaxed);
+			if (const Query* q = find(head, m))
+				return *q;
+
+			auto* q = new Query(m);
+			q->reserve(w._reserved);
+			for (id_type id = 0; id <= w._maxId.id; ++id)
+				if (w._masks[id].test(m))
+					q->insert({id, w._versions[id]});
+			w._queries.push(q);
+			q->_next = head;
+			w._queryList.store(q, std::memory_order_release);
+			return *q;
 		}
-		static ent_type maxId() { return _maxId; }
 
+		template <class T>
+		static typename Storage<T>::type& storage() {
+			return *static_cast<typename Storage<T>::type*>(current().pool(Component<T>::Index));
+		}
+		static Archetypes& archetypes() { return current()._archetypes; }
+
+		// Routes World::commands() on this thread to a buffer kept for `key` until the
+		// scope ends. The scheduler records each system under its index, so playback
+		// order doesn't depend on which thread ran what.
+		class Recording final : NoCopy
+		{
+		public:
+			explicit Recording(index_type key) : _prev(_key) { _key = key; }
+			~Recording() { _key = _prev; }
+		private:
+			index_type _prev;
+		};
+
+		// The command buffer of the current Recording key in the current world, else
+		// the calling thread's
+		static CommandBuffer& commands();
+		// Sync point: plays back every buffer into the current world, the keyed ones
+		// by key and then each thread's, until all are empty.
+		// Call functors run here and should use the World API directly.
+		static void flush();
+
+		// Write access: stamps tracked components with the current tick
 		template <class T>
 		static T& getComponent(ent_type e) {
-			return Storage<T>::type::get(e);
+			if constexpr (Tracked<T>::value)
+				touch<T>(e);
+			return storage<T>().get(e);
+		}
+		template <class T>
+		static const T& readComponent(ent_type e) {
+			return storage<T>().get(e);
+		}
+
+		static tick_type tick() { return current()._tick; }
+		static void advance() { ++current()._tick; }
+
+		template <class T>
+		static void touch(ent_type e) {
+			World& w = current();
+			(*w._stamps[Component<T>::Index])[e.id] = w._tick;
+		}
+		// Whether e has a T written at or after tick `since`. T must opt into tracking;
+		// there are no stamps to answer with otherwise
+		template <class T>
+		static bool changed(ent_type e, tick_type since) {
+			static_assert(Tracked<T>::value, "changed<T> needs T::TrackChanges = true");
+			const World& w = current();
+			return w._masks[e.id].test(Component<T>::Bit)
+				&& (*w._stamps[Component<T>::Index])[e.id] >= since;
 		}
 
 		template <class T>
 		static void addComponent(ent_type e, const T& t) {
-			_masks[e.id].set(Component<T>::Bit);
-			Storage<T>::type::add(e,t);
+			World& w = current();
+			const Mask prev = w._masks[e.id];
+			w._masks[e.id].set(Component<T>::Bit);
+			storage<T>().add(e,t);
+			if constexpr (Tracked<T>::value) {
+				auto*& stamps = w._stamps[Component<T>::Index];
+				if (!stamps)
+					stamps = new Bag<tick_type,Params.InitialEntities>;
+				stamps->ensure(e.id+1);
+				(*stamps)[e.id] = w._tick;
+			}
+			w.updateQueries(e, prev);
 		}
 		template <class T, class...Ts>
 		static void addComponents(ent_type e, const T& t, const Ts&... ts) {
@@ -252,8 +927,11 @@ namespace bagel
 
 		template <class T>
 		static void delComponent(ent_type e) {
-			_masks[e.id].clear(Component<T>::Bit);
-			Storage<T>::type::del(e);
+			World& w = current();
+			const Mask prev = w._masks[e.id];
+			w._masks[e.id].clear(Component<T>::Bit);
+			storage<T>().del(e);
+			w.updateQueries(e, prev);
 		}
 		template <class T, class ...Ts>
 		static void delComponents(ent_type e) {
@@ -263,11 +941,304 @@ namespace bagel
 		}
 
 	private:
-		static inline ent_type								_maxId{-1};
-		static inline Bag<Mask,		Params.InitialEntities> _masks;
-		static inline Bag<ent_type,	Params.IdBagSize>		_ids;
+		static const Query* find(const Query* q, const Mask& m) {
+			while (q && !(q->mask() == m))
+				q = q->_next;
+			return q;
+		}
+		void updateQueries(ent_type e, const Mask& prev) {
+			for (index_type i = 0; i < _queries.size(); ++i)
+				_queries[i]->update(e, prev, _masks[e.id]);
+		}
+		void* pool(index_type comp) {
+			if (!_pools[comp])
+				_pools[comp] = compOps[comp].create(_archetypes);
+			return _pools[comp];
+		}
+
+		struct QueryBag : Bag<Query*,Params.InitialQueries> {
+			~QueryBag() { for (const Query* q : *this) delete q; }
+		};
+
+		struct LocalBuffer {
+			std::uint64_t	world;
+			index_type		key;
+			CommandBuffer*	buffer;
+		};
+
+		static inline thread_local World*		_current = nullptr;
+		static inline thread_local index_type	_key = -1;
+		static inline thread_local LocalBuffer	_local = {0, -1, nullptr};
+		static inline std::atomic<std::uint64_t>	_serials{0};
+
+		ent_type								_maxId{-1};
+		Bag<Mask,		Params.InitialEntities>	_masks;
+		Bag<ent_type,	Params.IdBagSize>		_ids;
+		Bag<version_type,Params.InitialEntities>	_versions;
+		QueryBag								_queries;
+		std::atomic<const Query*>				_queryList{nullptr};
+		std::mutex								_queryMutex;
+		size_type								_reserved = 0;
+		Archetypes								_archetypes;
+		void*									_pools[Params.MaxComponents] = {};
+		Bag<tick_type,Params.InitialEntities>*	_stamps[Params.MaxComponents] = {};
+		tick_type								_tick = 1;
+		const std::uint64_t						_serial = ++_serials;
+		std::mutex								_bufferMutex;
+		Bag<CommandBuffer*,Params.IdBagSize>	_buffers;
+		Bag<std::thread::id,Params.IdBagSize>	_bufferThreads;
+		Bag<CommandBuffer*,Params.IdBagSize>	_keyedBuffers;
+	};
+
+	// Records structural changes to apply later at a sync point, so systems can spawn
+	// and destroy while others iterate. create() hands out provisional handles that
+	// only mean something inside the buffer; play() maps them to real entities.
+	class CommandBuffer final : NoCopy
+	{
+	public:
+		CommandBuffer() = default;
+		~CommandBuffer() {
+			clear();
+			for (index_type i = 0; i < _blocks.size(); ++i)
+				DefaultAllocator::deallocate(_blocks[i].data, _blocks[i].capacity, Align);
+		}
+
+		ent_type create() {
+			const index_type n = _created++;
+			emplace<Create>(n);
+			return {-2 - n, 0};
+		}
+		template <class T>
+		void add(ent_type e, const T& t) { emplace<Add<T>>(e, t); }
+		template <class T, class ...Ts>
+		void addAll(ent_type e, const T& t, const Ts&... ts) {
+			add(e, t);
+			if constexpr (sizeof...(Ts)>0)
+				addAll(e, ts...);
+		}
+		template <class T>
+		void del(ent_type e) { emplace<Del<T>>(e); }
+		void destroy(ent_type e) { emplace<Destroy>(e); }
+
+		// Runs f() at playback, in order with the other commands
+		template <class F>
+		void call(F&& f) { emplace<Call<std::decay_t<F>>>(std::forward<F>(f)); }
+		// Runs f(e) at playback with e resolved, e.g. to hand a new entity to Box2D
+		template <class F>
+		void call(ent_type e, F&& f) { emplace<CallWith<std::decay_t<F>>>(e, std::forward<F>(f)); }
+
+		// Moves other's commands after this buffer's, keeping its provisional handles apart
+		void merge(CommandBuffer& other) {
+			for (index_type i = 0; i < other._blocks.size(); ++i) {
+				Block b = other._blocks[i];
+				b.base += _created;
+				_blocks.push(b);
+			}
+			_cur = _blocks.size();
+			_created += other._created;
+			_count += other._count;
+			other._blocks.clear();
+			other.reset();
+		}
+
+		// Applies every command to the current world, in recording order. Commands a
+		// call records into this buffer during playback are played in the same pass;
+		// records never move, so only the block bag is re-read as it grows.
+		void play() {
+			for (index_type i = 0; i < _blocks.size(); ++i)
+				for (size_type at = 0; at < _blocks[i].used; ) {
+					unsigned char* const record = _blocks[i].data + at;
+					const Header& h = *reinterpret_cast<Header*>(record);
+					void* const c = record + round(sizeof(Header));
+					at += h.size;
+					_resolved.ensure(_created);
+					h.apply(c, Playback{&_resolved[0], _blocks[i].base});
+					h.destroy(c);
+				}
+			reset();
+		}
+		// Drops every command without applying it
+		void clear() {
+			for (index_type i = 0; i < _blocks.size(); ++i)
+				visit(_blocks[i], [](const Header& h, void* c) { h.destroy(c); });
+			reset();
+		}
+
+		bool empty() const { return _count == 0; }
+		size_type size() const { return _count; }
+	private:
+		struct Playback {
+			ent_type*	resolved;
+			index_type	base;
+			ent_type operator()(ent_type e) const {
+				return e.id <= -2 ? resolved[base - 2 - e.id] : e;
+			}
+		};
+		struct Create {
+			index_type n;
+			void apply(const Playback& p) { p.resolved[p.base + n] = World::createEntity(); }
+		};
+		template <class T> struct Add {
+			ent_type e; T t;
+			void apply(const Playback& p) { World::addComponent(p(e), t); }
+		};
+		template <class T> struct Del {
+			ent_type e;
+			void apply(const Playback& p) { World::delComponent<T>(p(e)); }
+		};
+		struct Destroy {
+			ent_type e;
+			void apply(const Playback& p) { World::destroyEntity(p(e)); }
+		};
+		template <class F> struct Call {
+			F f;
+			void apply(const Playback&) { f(); }
+		};
+		template <class F> struct CallWith {
+			ent_type e; F f;
+			void apply(const Playback& p) { f(p(e)); }
+		};
+
+		struct Header {
+			void		(*apply)(void*, const Playback&);
+			void		(*destroy)(void*);
+			size_type	size;
+		};
+		struct Block {
+			unsigned char*	data;
+			size_type		used, capacity;
+			index_type		base;
+		};
+
+		static constexpr std::size_t Align = alignof(std::max_align_t);
+		static constexpr size_type BlockSize = 4096;
+		static constexpr size_type round(std::size_t n) {
+			return static_cast<size_type>((n + Align - 1) / Align * Align);
+		}
+
+		template <class C, class ...Args>
+		void emplace(Args&&... args) {
+			static_assert(alignof(C) <= Align, "Over-aligned command payload");
+			constexpr size_type size = round(sizeof(Header)) + round(sizeof(C));
+			unsigned char* at = bytes(size);
+			new (at) Header{
+				[](void* c, const Playback& p) { static_cast<C*>(c)->apply(p); },
+				[](void* c) { static_cast<C*>(c)->~C(); },
+				size};
+			new (at + round(sizeof(Header))) C{std::forward<Args>(args)...};
+			++_count;
+		}
+
+		// Records never move once written; merged blocks are never appended to
+		unsigned char* bytes(size_type size) {
+			for (; _cur < _blocks.size(); ++_cur) {
+				Block& b = _blocks[_cur];
+				if (b.used == 0 && b.capacity < size) {
+					DefaultAllocator::deallocate(b.data, b.capacity, Align);
+					b.data = static_cast<unsigned char*>(DefaultAllocator::allocate(size, Align));
+					b.capacity = size;
+				}
+				if (b.used + size <= b.capacity) {
+					b.used += size;
+					return b.data + b.used - size;
+				}
+			}
+			const size_type capacity = std::max(BlockSize, size);
+			_blocks.push({static_cast<unsigned char*>(DefaultAllocator::allocate(capacity, Align)),
+				size, capacity, 0});
+			return _blocks[_cur].data;
+		}
+
+		template <class F>
+		static void visit(const Block& b, F&& f) {
+			for (size_type at = 0; at < b.used; ) {
+				const Header& h = *reinterpret_cast<Header*>(b.data + at);
+				const size_type size = h.size;
+				f(h, b.data + at + round(sizeof(Header)));
+				at += size;
+			}
+		}
+
+		void reset() {
+			for (index_type i = 0; i < _blocks.size(); ++i) {
+				_blocks[i].used = 0;
+				_blocks[i].base = 0;
+			}
+			_cur = 0;
+			_created = 0;
+			_count = 0;
+		}
+
+		Bag<Block,Params.InitialQueries>		_blocks;
+		Bag<ent_type,Params.InitialEntities>	_resolved;
+		index_type								_cur = 0;
+		size_type								_created = 0;
+		size_type								_count = 0;
 	};
 
+	inline World::~World() {
+		for (index_type i = 0; i < _buffers.size(); ++i)
+			delete _buffers[i];
+		for (index_type i = 0; i < _keyedBuffers.size(); ++i)
+			delete _keyedBuffers[i];
+		for (index_type i = 0; i <= compCounter; ++i) {
+			if (_pools[i])
+				compOps[i].destroy(_pools[i]);
+			delete _stamps[i];
+		}
+	}
+
+	inline CommandBuffer& World::commands() {
+		World& w = current();
+		if (_local.world == w._serial && _local.key == _key)
+			return *_local.buffer;
+
+		std::lock_guard<std::mutex> lock(w._bufferMutex);
+		CommandBuffer* b;
+		if (_key >= 0) {
+			while (w._keyedBuffers.size() <= _key)
+				w._keyedBuffers.push(nullptr);
+			if (!w._keyedBuffers[_key])
+				w._keyedBuffers[_key] = new CommandBuffer;
+			b = w._keyedBuffers[_key];
+		}
+		else {
+			const std::thread::id self = std::this_thread::get_id();
+			index_type i = 0;
+			while (i < w._buffers.size() && w._bufferThreads[i] != self)
+				++i;
+			if (i == w._buffers.size()) {
+				w._buffers.push(new CommandBuffer);
+				w._bufferThreads.push(self);
+			}
+			b = w._buffers[i];
+		}
+		_local = {w._serial, _key, b};
+		return *b;
+	}
+
+	inline void World::flush() {
+		World& w = current();
+		// A call may record into a buffer that was already played this pass
+		for (bool played = true; played; ) {
+			played = false;
+			for (index_type i = 0; ; ++i) {
+				CommandBuffer* b;
+				{
+					std::lock_guard<std::mutex> lock(w._bufferMutex);
+					const index_type keyed = w._keyedBuffers.size();
+					if (i >= keyed + w._buffers.size())
+						break;
+					b = i < keyed ? w._keyedBuffers[i] : w._buffers[i - keyed];
+				}
+				if (b && !b->empty()) {
+					b->play();
+					played = true;
+				}
+			}
+		}
+	}
+
 	class Entity
 	{
 	public:
@@ -276,10 +1247,12 @@ namespace bagel
 
 		static Entity create() { return World::createEntity(); }
 		void destroy() const { World::destroyEntity(_ent); }
+		bool alive() const { return World::alive(_ent); }
 
 		const Mask& mask() const { return World::mask(_ent); }
 
 		template <class T> T& get() const { return World::getComponent<T>(_ent); }
+		template <class T> const T& read() const { return World::readComponent<T>(_ent); }
 		template <class T> void add(const T& t) const {
 			return World::addComponent<T>(_ent, t);
 		}
@@ -296,10 +1269,45 @@ namespace bagel
 
 		template <class T> bool has() const { return mask().test(Component<T>::Bit); }
 		bool test(const Mask& m) const { return mask().test(m); }
+
+		template <class ...Ts> bool changedSince(tick_type since) const {
+			return (World::changed<Ts>(_ent, since) || ...);
+		}
 	private:
 		ent_type _ent;
 	};
 
+	// Entities of a query with any of the tracked Ts written at or after a tick
+	template <class ...Ts>
+	class Changed
+	{
+	public:
+		class iterator
+		{
+		public:
+			iterator(const ent_type* at, const ent_type* end, tick_type since)
+				: _at(at), _end(end), _since(since) { skip(); }
+			ent_type operator*() const { return *_at; }
+			iterator& operator++() { ++_at; skip(); return *this; }
+			bool operator!=(const iterator& o) const { return _at != o._at; }
+		private:
+			void skip() {
+				while (_at != _end && !(World::changed<Ts>(*_at, _since) || ...))
+					++_at;
+			}
+			const ent_type*	_at;
+			const ent_type*	_end;
+			tick_type		_since;
+		};
+
+		Changed(const Query& q, tick_type since) : _query(q), _since(since) {}
+		iterator begin() const { return {_query.begin(), _query.end(), _since}; }
+		iterator end() const { return {_query.end(), _query.end(), _since}; }
+	private:
+		const Query&	_query;
+		tick_type		_since;
+	};
+
 	class MaskBuilder
 	{
 	public:
@@ -312,4 +1320,414 @@ namespace bagel
 	private:
 		Mask m;
 	};
+
+	template <class ...Ts>
+	class View
+	{
+	public:
+		View() : _query(World::query(mask())) {}
+
+		static const Mask& mask() {
+			static const Mask m = [] {
+				MaskBuilder b;
+				(b.set<Ts>(), ...);
+				return b.build();
+			}();
+			return m;
+		}
+
+		size_type size() const { return _query.size(); }
+		Entity operator[](index_type i) const { return _query[i]; }
+		const ent_type* begin() const { return _query.begin(); }
+		const ent_type* end() const { return _query.end(); }
+
+		// Filters on the view's own components unless others are named; all must be tracked
+		Changed<Ts...> changedSince(tick_type since) const { return {_query, since}; }
+		template <class U, class ...Us>
+		Changed<U,Us...> changedSince(tick_type since) const { return {_query, since}; }
+
+		template <class F>
+		void each(F&& f) const {
+			if constexpr ((std::is_same_v<typename Storage<Ts>::type, ArchetypeStorage<Ts>> && ...))
+				World::archetypes().each<Ts...>([&](ent_type e, Ts&... ts) {
+					f(e, ts...);
+					(touchIfTracked<Ts>(e), ...);
+				});
+			else
+				for (const ent_type e : _query)
+					f(e, World::getComponent<Ts>(e)...);
+		}
+	private:
+		template <class T>
+		static void touchIfTracked(ent_type e) {
+			if constexpr (Tracked<T>::value)
+				World::touch<T>(e);
+		}
+
+		const Query& _query;
+	};
+
+	using resource_mask = std::uint64_t;
+	inline index_type	resourceCounter = -1;
+
+	inline resource_mask registerResource() {
+		assert(resourceCounter + 1 < static_cast<index_type>(sizeof(resource_mask)*8)
+			&& "More resources than bits in resource_mask");
+		return resource_mask{1} << ++resourceCounter;
+	}
+
+	// Anything a system can read or write: a component type, or a token type
+	// standing for state outside the world (a physics world, a renderer)
+	template <class T>
+	struct Resource final : NoInstance
+	{
+		static inline const resource_mask	Bit = registerResource();
+	};
+
+	class ThreadPool final : NoCopy
+	{
+	public:
+		struct Task {
+			void	(*fn)(void*);
+			void*	arg;
+		};
+
+		explicit ThreadPool(int workers = defaultWorkers())
+			: _count(workers), _queues(new Queue[std::max(workers, 1)]),
+			  _threads(new std::thread[std::max(workers, 1)]) {
+			for (int i = 0; i < _count; ++i)
+				_threads[i] = std::thread([this, i] { work(i); });
+		}
+		~ThreadPool() {
+			{
+				std::lock_guard<std::mutex> lock(_sleep);
+				_stop = true;
+			}
+			_wake.notify_all();
+			for (int i = 0; i < _count; ++i)
+				_threads[i].join();
+		}
+
+		// Workers push to their own queue; other threads spread tasks round-robin.
+		// A task that finds its queue full runs right away on the submitting thread.
+		void submit(Task t) {
+			const int q = _self == this ? _index
+				: static_cast<int>(_next.fetch_add(1, std::memory_order_relaxed) % std::max(_count, 1));
+			bool queued;
+			{
+				std::lock_guard<std::mutex> lock(_queues[q].mutex);
+				queued = _queues[q].push(t);
+			}
+			if (!queued) {
+				t.fn(t.arg);
+				return;
+			}
+			_queued.fetch_add(1);
+			{
+				std::lock_guard<std::mutex> lock(_sleep);
+			}
+			_wake.notify_one();
+		}
+
+		// Runs one queued task on the calling thread, if there is any
+		bool runOne() {
+			Task t;
+			if (!take(-1, t))
+				return false;
+			t.fn(t.arg);
+			return true;
+		}
+
+		int workers() const { return _count; }
+
+		// The calling worker's index, or workers() on any thread outside the pool
+		int workerIndex() const { return _self == this ? _index : _count; }
+
+		static int defaultWorkers() {
+			return static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) - 1;
+		}
+	private:
+		// Fixed-size ring, so queuing never allocates. Indices only grow; they wrap when used
+		struct Queue {
+			static constexpr unsigned	Capacity = 256;
+
+			std::mutex	mutex;
+			Task		tasks[Capacity];
+			unsigned	head = 0, tail = 0;
+
+			bool empty() const { return head == tail; }
+			bool push(Task t) {
+				if (tail - head == Capacity)
+					return false;
+				tasks[tail++ % Capacity] = t;
+				return true;
+			}
+			Task popBack() { return tasks[--tail % Capacity]; }
+			Task popFront() { return tasks[head++ % Capacity]; }
+		};
+
+		// Own queue from the back (most recent, still warm), others' from the front
+		bool take(int self, Task& out) {
+			const int n = std::max(_count, 1);
+			if (self >= 0) {
+				std::lock_guard<std::mutex> lock(_queues[self].mutex);
+				if (!_queues[self].empty()) {
+					out = _queues[self].popBack();
+					_queued.fetch_sub(1);
+					return true;
+				}
+			}
+			for (int i = 1; i <= n; ++i) {
+				Queue& q = _queues[(self + i + n) % n];
+				std::lock_guard<std::mutex> lock(q.mutex);
+				if (!q.empty()) {
+					out = q.popFront();
+					_queued.fetch_sub(1);
+					return true;
+				}
+			}
+			return false;
+		}
+
+		void work(int index) {
+			_self = this;
+			_index = index;
+			while (true) {
+				Task t;
+				if (take(index, t)) {
+					t.fn(t.arg);
+					continue;
+				}
+				std::unique_lock<std::mutex> lock(_sleep);
+				_wake.wait(lock, [this] { return _stop || _queued.load() > 0; });
+				if (_stop && _queued.load() == 0)
+					return;
+			}
+		}
+
+		static inline thread_local const ThreadPool*	_self = nullptr;
+		static inline thread_local int					_index = 0;
+
+		const int						_count;
+		std::unique_ptr<Queue[]>		_queues;
+		std::unique_ptr<std::thread[]>	_threads;
+		std::atomic<unsigned>			_next{0};
+		std::atomic<int>				_queued{0};
+		std::mutex						_sleep;
+		std::condition_variable			_wake;
+		bool							_stop = false;
+	};
+
+	// Splits [0, count) into ranges that run on the pool. The waiting thread helps
+	// with queued tasks, so a loop finishes even on a pool without workers.
+	class ParallelFor final : NoCopy
+	{
+	public:
+		// worker is the pool's workerIndex() of the thread running the range
+		using Body = void (*)(int begin, int end, int worker, void* context);
+
+		static constexpr int MaxRanges = 64;
+
+		// At most one range per worker plus the caller, each at least minRange long
+		void start(ThreadPool& pool, Body body, void* context, int count, int minRange) {
+			_pool = &pool;
+			_body = body;
+			_context = context;
+			const int most = std::max(1, count / std::max(minRange, 1));
+			const int ranges = std::min({most, pool.workers() + 1, MaxRanges});
+			_pending.store(ranges);
+			for (int i = 0; i < ranges; ++i) {
+				_ranges[i] = {this, static_cast<int>(static_cast<long long>(count) * i / ranges),
+					static_cast<int>(static_cast<long long>(count) * (i+1) / ranges)};
+				pool.submit({run, &_ranges[i]});
+			}
+		}
+
+		void wait() {
+			while (_pending.load() > 0)
+				if (!_pool->runOne())
+					std::this_thread::yield();
+		}
+	private:
+		struct Range {
+			ParallelFor*	owner;
+			int				begin, end;
+		};
+
+		static void run(void* arg) {
+			const Range& r = *static_cast<Range*>(arg);
+			ParallelFor& self = *r.owner;
+			self._body(r.begin, r.end, self._pool->workerIndex(), self._context);
+			self._pending.fetch_sub(1);
+		}
+
+		ThreadPool*			_pool = nullptr;
+		Body				_body = nullptr;
+		void*				_context = nullptr;
+		Range				_ranges[MaxRanges];
+		std::atomic<int>	_pending{0};
+	};
+
+	// Runs registered systems once per call. Two systems conflict when one writes
+	// what the other reads or writes; conflicting systems keep their registration
+	// order, everything else may run concurrently on the pool.
+	class Scheduler final : NoCopy
+	{
+	public:
+		static constexpr int MaxSystems = 64;
+
+		class System final
+		{
+		public:
+			template <class ...Ts> System& reads() { _reads |= (Resource<Ts>::Bit | ...); return *this; }
+			template <class ...Ts> System& writes() { _writes |= (Resource<Ts>::Bit | ...); return *this; }
+			// Creates or destroys entities, or adds and removes components
+			System& exclusive() { _exclusive = true; return *this; }
+			// Must run on the thread calling Scheduler::run (SDL video, events)
+			System& onMainThread() { _main = true; return *this; }
+		private:
+			friend class Scheduler;
+
+			bool conflicts(const System& o) const {
+				return _exclusive || o._exclusive
+					|| (_writes & (o._reads | o._writes)) || (o._writes & _reads);
+			}
+
+			std::function<void()>	_fn;
+			resource_mask			_reads = 0, _writes = 0;
+			bool					_exclusive = false, _main = false;
+			std::uint64_t			_next = 0;
+			int						_preds = 0;
+			Scheduler*				_owner = nullptr;
+			index_type				_index = 0;
+		};
+
+		explicit Scheduler(ThreadPool& pool) : _pool(pool) {}
+
+		template <class F>
+		System& add(F&& f) {
+			assert(_count < MaxSystems && "More systems than Scheduler::MaxSystems");
+			System& s = _systems[_count];
+			s._fn = std::forward<F>(f);
+			s._owner = this;
+			s._index = _count++;
+			_built = false;
+			return s;
+		}
+
+		void run() {
+			if (!_built)
+				build();
+			_world = &World::current();
+			_pending.store(_count);
+			for (index_type i = 0; i < _count; ++i)
+				_remaining[i].store(_systems[i]._preds);
+			for (index_type i = 0; i < _count; ++i)
+				if (_systems[i]._preds == 0)
+					dispatch(i);
+
+			while (_pending.load() > 0) {
+				index_type main = -1;
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					if (_mainCount > 0)
+						main = _main[--_mainCount];
+				}
+				if (main != -1)
+					execute(&_systems[main]);
+				else if (!_pool.runOne()) {
+					std::unique_lock<std::mutex> lock(_mutex);
+					_done.wait(lock, [this] { return _pending.load() == 0 || _mainCount > 0; });
+				}
+			}
+			// The last system retires under the lock; don't return while it holds it
+			{
+				std::lock_guard<std::mutex> lock(_mutex);
+			}
+			World::flush();
+		}
+	private:
+		void build() {
+			for (index_type i = 0; i < _count; ++i) {
+				_systems[i]._next = 0;
+				_systems[i]._preds = 0;
+			}
+			for (index_type i = 0; i < _count; ++i)
+				for (index_type j = i+1; j < _count; ++j)
+					if (_systems[i].conflicts(_systems[j])) {
+						_systems[i]._next |= std::uint64_t{1} << j;
+						++_systems[j]._preds;
+					}
+			_built = true;
+		}
+
+		void dispatch(index_type i) {
+			if (_systems[i]._main) {
+				{
+					std::lock_guard<std::mutex> lock(_mutex);
+					_main[_mainCount++] = i;
+				}
+				_done.notify_all();
+			}
+			else
+				_pool.submit({&execute, &_systems[i]});
+		}
+
+		static void execute(void* p) {
+			System& s = *static_cast<System*>(p);
+			Scheduler& self = *s._owner;
+			{
+				World::Scope scope(*self._world);
+				World::Recording recording(s._index);
+				s._fn();
+			}
+			for (index_type j = 0; j < self._count; ++j)
+				if ((s._next >> j & 1) && self._remaining[j].fetch_sub(1) == 1)
+					self.dispatch(j);
+			std::lock_guard<std::mutex> lock(self._mutex);
+			if (self._pending.fetch_sub(1) == 1)
+				self._done.notify_all();
+		}
+
+		ThreadPool&				_pool;
+		System					_systems[MaxSystems];
+		std::atomic<int>		_remaining[MaxSystems];
+		index_type				_count = 0;
+		bool					_built = false;
+		World*					_world = nullptr;
+		std::atomic<int>		_pending{0};
+		index_type				_main[MaxSystems];
+		index_type				_mainCount = 0;
+		std::mutex				_mutex;
+		std::condition_variable	_done;
+	};
+
+	// Hands the latest value from one writer thread to one reader thread without
+	// locks. Neither side ever waits: the writer fills back() and publishes it,
+	// the reader swaps in the newest published value, skipping any it missed.
+	template <class T>
+	class TripleBuffer final : NoCopy
+	{
+	public:
+		// Writer side. The slot may still hold an older value; reuse or clear it
+		T& back() { return _slots[_back]; }
+		void publish() {
+			_back = _middle.exchange(_back | Fresh, std::memory_order_acq_rel) & Index;
+		}
+
+		// Reader side. Returns whether front() changed
+		bool update() {
+			if (!(_middle.load(std::memory_order_relaxed) & Fresh))
+				return false;
+			_front = _middle.exchange(_front, std::memory_order_acq_rel) & Index;
+			return true;
+		}
+		const T& front() const { return _slots[_front]; }
+	private:
+		static constexpr int Index = 3, Fresh = 4;
+
+		T					_slots[3]{};
+		int					_back = 0, _front = 1;
+		std::atomic<int>	_middle{2};
+	};
 }
@@ -1,7 +1,9 @@
 #pragma once
 
 constexpr Bagel Params{
-	.DynamicResize = true
+	.DynamicResize = true,
+	.MaxComponents = 32
 };
 
 //BAGEL_STORAGE(Position,PackedStorage)
+//BAGEL_STORAGE(Movement,ArchetypeStorage)
@@ -0,0 +1,163 @@
+// Microbenchmarks for the bagel ECS, printed as JSON.
+// Usage: bagel_bench [max_entities]   (default 1000000)
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <vector>
+#include "bagel.h"
+using namespace bagel;
+
+template <template <class> class S, int Id>
+struct BenchComp { float value = 1; };
+
+namespace bagel {
+	template <template <class> class S, int Id>
+	struct Storage<BenchComp<S,Id>> { using type = S<BenchComp<S,Id>>; };
+}
+
+static volatile float sink;
+static bool first = true;
+
+using Clock = std::chrono::steady_clock;
+
+static void report(const char* name, const char* storage, int entities, long long ops, Clock::duration elapsed) {
+	const double ns = static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+	std::printf("%s\n    {\"name\": \"%s\", \"storage\": \"%s\", \"entities\": %d, \"ops\": %lld, "
+		"\"ns_per_op\": %.3f, \"entities_per_sec\": %.0f}",
+		first ? "" : ",", name, storage, entities, ops, ns / static_cast<double>(ops),
+		static_cast<double>(ops) * 1e9 / ns);
+	first = false;
+}
+
+// Small sizes are repeated so every measurement covers about a million operations
+static int repeats(int n) { return std::max(1, 1000000 / n); }
+
+template <template <class> class S>
+void benchStorage(const char* storage, int n) {
+	using A = BenchComp<S,0>;
+	using B = BenchComp<S,1>;
+	constexpr bool Gettable = !std::is_same_v<S<A>, TaggedStorage<A>>;
+	std::vector<ent_type> ents(n);
+
+	{
+		World world;
+		World::Scope scope(world);
+		const int reps = repeats(n);
+		const auto start = Clock::now();
+		for (int r = 0; r < reps; ++r) {
+			for (int i = 0; i < n; ++i) {
+				ents[i] = World::createEntity();
+				World::addComponent(ents[i], A{});
+			}
+			for (int i = 0; i < n; ++i)
+				World::destroyEntity(ents[i]);
+		}
+		report("create_destroy", storage, n, 2LL*n*reps, Clock::now() - start);
+	}
+
+	World world;
+	World::Scope scope(world);
+	for (int i = 0; i < n; ++i)
+		ents[i] = World::createEntity();
+	{
+		const int reps = repeats(n);
+		const auto start = Clock::now();
+		for (int r = 0; r < reps; ++r) {
+			for (int i = 0; i < n; ++i)
+				World::addComponents(ents[i], A{}, B{});
+			for (int i = 0; i < n; ++i)
+				World::delComponents<A,B>(ents[i]);
+		}
+		report("add_del_components", storage, n, 2LL*n*reps, Clock::now() - start);
+	}
+
+	// Half the world matches A+B, the other half has only A
+	for (int i = 0; i < n; ++i) {
+		World::addComponent(ents[i], A{});
+		if (i % 2 == 0)
+			World::addComponent(ents[i], B{});
+	}
+
+	if constexpr (Gettable) {
+		std::mt19937 rng(42);
+		std::vector<ent_type> order(ents);
+		std::shuffle(order.begin(), order.end(), rng);
+		const int reps = repeats(n);
+		float sum = 0;
+		const auto start = Clock::now();
+		for (int r = 0; r < reps; ++r)
+			for (int i = 0; i < n; ++i)
+				sum += World::getComponent<A>(order[i]).value;
+		report("random_get", storage, n, 1LL*n*reps, Clock::now() - start);
+		sink = sum;
+	}
+
+	{
+		const Mask& m = View<A,B>::mask();
+		const int reps = repeats(n);
+		long long matched = 0;
+		const auto start = Clock::now();
+		for (int r = 0; r < reps; ++r)
+			for (ent_type e = {0}; e.id <= World::maxId().id; ++e.id)
+				matched += World::mask(e).test(m);
+		report("masked_scan", storage, n, 1LL*n*reps, Clock::now() - start);
+		sink = static_cast<float>(matched);
+	}
+
+	if constexpr (Gettable) {
+		const int reps = repeats(n);
+		float sum = 0;
+		const View<A,B> view;
+		const auto start = Clock::now();
+		for (int r = 0; r < reps; ++r)
+			view.each([&](ent_type, A& a, B& b) { sum += a.value + b.value; });
+		report("view_each", storage, n, 1LL*view.size()*reps, Clock::now() - start);
+		sink = sum;
+	}
+}
+
+// Random masks over the first `components` bits, each tested against a two-bit query
+template <class M>
+void benchMask(const char* name, int n, int components) {
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<index_type> bit(0, components-1);
+	std::vector<M> masks(n);
+	for (M& m : masks)
+		for (int i = 0; i < 4; ++i)
+			m.set(M::bit(bit(rng)));
+	M query;
+	query.set(M::bit(bit(rng)));
+	query.set(M::bit(bit(rng)));
+
+	const int reps = repeats(n);
+	long long matched = 0;
+	const auto start = Clock::now();
+	for (int r = 0; r < reps; ++r)
+		for (const M& m : masks)
+			matched += m.test(query);
+	report("mask_test", name, n, 1LL*n*reps, Clock::now() - start);
+	sink = static_cast<float>(matched);
+}
+
+int main(int argc, char* argv[]) {
+	const int max = argc > 1 ? std::atoi(argv[1]) : 1000000;
+
+	std::printf("{\n  \"benchmarks\": [");
+	for (const int n : {1000, 100000, 1000000}) {
+		if (n > max)
+			break;
+		benchStorage<SparseStorage>("sparse", n);
+		benchStorage<PackedStorage>("packed", n);
+		benchStorage<TaggedStorage>("tagged", n);
+		benchStorage<ArchetypeStorage>("archetype", n);
+		// Independent of bagel_cfg.h: a full single word against two and four words
+		benchMask<SingleMask>("single_mask", n, BitsetWidth);
+		benchMask<BasicMultiMask<2*BitsetWidth>>("multi_mask_2_words", n, 2*BitsetWidth);
+		benchMask<BasicMultiMask<4*BitsetWidth>>("multi_mask_4_words", n, 4*BitsetWidth);
+	}
+	std::printf("\n  ]\n}\n");
+	return 0;
+}
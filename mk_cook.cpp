@@ -0,0 +1,292 @@
+// Offline sprite cook for the fighter sheets.
+// Usage: mk_cook <raw res dir> <output dir>
+//
+// For each fighter it cuts every frame referenced by its sprite tables out of the raw
+// sheet, turns the color key into alpha, trims the frame to its opaque bounds and
+// shelf-packs the result into "<name>.atlas.png". The matching "<name>.atlas" frame
+// table maps (state, frame) to the packed rect. The game reads both back in
+// MK::TextureSystem::decodeAtlas and MK::SpriteAtlas::loadTable.
+//
+// The atlas is written 8-bit indexed: the arcade art only uses a few hundred colors,
+// so the game keeps one byte per pixel on the GPU and recolors fighters by palette.
+
+#include <SDL3/SDL.h>
+#include <SDL3_image/SDL_image.h>
+#include <algorithm>
+#include <climits>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "mortal_kombat_info.h"
+using namespace mortal_kombat;
+
+static constexpr int MAX_ATLAS_SIZE = 8192;
+static constexpr int PADDING = 1; // Keeps linear filtering from bleeding between frames
+
+struct Fighter {
+    const char* name;
+    const std::array<SpriteInfo, CHARACTER_SPRITE_SIZE>& sprite;
+    const std::array<SpriteInfo, SPECIAL_ATTACK_SPRITE_SIZE>& special;
+};
+
+static const Fighter FIGHTERS[] = {
+    {"Sub-Zero", SUBZERO_SPRITE_ARRAY, SUBZERO_SPECIAL_SPRITE_ARRAY},
+    {"Liu Kang", LIU_KANG_SPRITE_ARRAY, LIU_KANG_SPECIAL_SPRITE_ARRAY},
+};
+
+/// A cell of the raw sheet; the same cell can be referenced by several states.
+struct Cell {
+    int x, y, w, h;
+    bool operator<(const Cell& o) const { return std::tie(x, y, w, h) < std::tie(o.x, o.y, o.w, o.h); }
+};
+
+struct Entry {
+    char group;
+    int index, frame;
+    int cell;
+};
+
+/// @brief Converts an RGBA32 surface to INDEX8, transparent pixels to ATLAS_TRANSPARENT_INDEX.
+/// The most used colors get a palette entry and the rare ones snap to the nearest of those;
+/// on the fighter sheets that only touches a few hundred stray pixels.
+static SDL_Surface* toIndexed(SDL_Surface* rgba, int& colorCount)
+{
+    const auto rgbAt = [rgba](int x, int y, bool& opaque) {
+        const Uint8* p = static_cast<Uint8*>(rgba->pixels) + y * rgba->pitch + x * 4;
+        opaque = p[3] != 0;
+        return static_cast<Uint32>(p[0]) << 16 | static_cast<Uint32>(p[1]) << 8 | p[2];
+    };
+
+    std::unordered_map<Uint32, long> counts;
+    for (int y = 0; y < rgba->h; ++y) {
+        for (int x = 0; x < rgba->w; ++x) {
+            bool opaque;
+            const Uint32 rgb = rgbAt(x, y, opaque);
+            if (opaque)
+                ++counts[rgb];
+        }
+    }
+    std::vector<std::pair<long, Uint32>> byCount;
+    for (const auto& [rgb, count] : counts)
+        byCount.push_back({count, rgb});
+    std::sort(byCount.begin(), byCount.end(), [](const auto& a, const auto& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    colorCount = static_cast<int>(byCount.size());
+
+    SDL_Color colors[ATLAS_PALETTE_SIZE] = {};
+    std::unordered_map<Uint32, Uint8> indexOf;
+    int used = 0;
+    for (int i = 0; i < ATLAS_PALETTE_SIZE; ++i) {
+        if (i == ATLAS_TRANSPARENT_INDEX)
+            continue;
+        if (used == static_cast<int>(byCount.size()))
+            break;
+        const Uint32 rgb = byCount[used++].second;
+        colors[i] = {static_cast<Uint8>(rgb >> 16), static_cast<Uint8>(rgb >> 8), static_cast<Uint8>(rgb), 255};
+        indexOf[rgb] = static_cast<Uint8>(i);
+    }
+    for (size_t i = used; i < byCount.size(); ++i) {
+        const Uint32 rgb = byCount[i].second;
+        int best = 0, bestDistance = INT_MAX;
+        for (int j = 0; j < ATLAS_PALETTE_SIZE; ++j) {
+            if (j == ATLAS_TRANSPARENT_INDEX || colors[j].a == 0)
+                continue;
+            const int dr = colors[j].r - static_cast<int>(rgb >> 16 & 0xFF);
+            const int dg = colors[j].g - static_cast<int>(rgb >> 8 & 0xFF);
+            const int db = colors[j].b - static_cast<int>(rgb & 0xFF);
+            const int distance = dr * dr + dg * dg + db * db;
+            if (distance < bestDistance) {
+                best = j;
+                bestDistance = distance;
+            }
+        }
+        indexOf[rgb] = static_cast<Uint8>(best);
+    }
+
+    SDL_Surface* indexed = SDL_CreateSurface(rgba->w, rgba->h, SDL_PIXELFORMAT_INDEX8);
+    if (!indexed)
+        return nullptr;
+    SDL_Palette* palette = SDL_CreateSurfacePalette(indexed);
+    if (!palette || !SDL_SetPaletteColors(palette, colors, 0, ATLAS_PALETTE_SIZE)) {
+        SDL_DestroySurface(indexed);
+        return nullptr;
+    }
+    for (int y = 0; y < rgba->h; ++y) {
+        Uint8* row = static_cast<Uint8*>(indexed->pixels) + y * indexed->pitch;
+        for (int x = 0; x < rgba->w; ++x) {
+            bool opaque;
+            const Uint32 rgb = rgbAt(x, y, opaque);
+            row[x] = opaque ? indexOf[rgb] : static_cast<Uint8>(ATLAS_TRANSPARENT_INDEX);
+        }
+    }
+    return indexed;
+}
+
+/// Cells of a sprite table, cut the same way as MK::getSpriteFrame (1px border dropped).
+static void collect(char group, const SpriteInfo* infos, int count,
+                    std::map<Cell, int>& cellIds, std::vector<Cell>& cells, std::vector<Entry>& entries)
+{
+    for (int i = 0; i < count; ++i) {
+        const SpriteInfo& info = infos[i];
+        for (int f = 0; f < info.frameCount; ++f) {
+            const Cell cell{static_cast<int>(info.x + f * (NEXT_FRAME_OFFSET + info.w)) + 1,
+                            static_cast<int>(info.y) + 1,
+                            static_cast<int>(info.w) - 2, static_cast<int>(info.h) - 2};
+            auto [it, inserted] = cellIds.emplace(cell, static_cast<int>(cells.size()));
+            if (inserted)
+                cells.push_back(cell);
+            entries.push_back({group, i, f, it->second});
+        }
+    }
+}
+
+static bool cook(const Fighter& fighter, const std::string& inDir, const std::string& outDir)
+{
+    const std::string sheetPath = inDir + "/" + fighter.name + ".png";
+    SDL_Surface* loaded = IMG_Load(sheetPath.c_str());
+    if (!loaded) {
+        std::fprintf(stderr, "Failed to load %s: %s\n", sheetPath.c_str(), SDL_GetError());
+        return false;
+    }
+    SDL_Surface* sheet = SDL_ConvertSurface(loaded, SDL_PIXELFORMAT_RGBA32);
+    SDL_DestroySurface(loaded);
+    if (!sheet) {
+        std::fprintf(stderr, "Failed to convert %s: %s\n", sheetPath.c_str(), SDL_GetError());
+        return false;
+    }
+
+    std::map<Cell, int> cellIds;
+    std::vector<Cell> cells;
+    std::vector<Entry> entries;
+    collect(ATLAS_STATE_GROUP, fighter.sprite.data(), CHARACTER_SPRITE_SIZE, cellIds, cells, entries);
+    collect(ATLAS_SPECIAL_GROUP, fighter.special.data(), SPECIAL_ATTACK_SPRITE_SIZE, cellIds, cells, entries);
+
+    // Bake the color key into alpha, then shrink every cell to its opaque bounds
+    const auto pixel = [sheet](int x, int y) {
+        return static_cast<Uint8*>(sheet->pixels) + y * sheet->pitch + x * 4;
+    };
+    std::vector<Cell> trimmed(cells.size());
+    for (size_t i = 0; i < cells.size(); ++i) {
+        const Cell& c = cells[i];
+        int minX = c.w, minY = c.h, maxX = -1, maxY = -1;
+        for (int y = std::max(0, c.y); y < std::min(sheet->h, c.y + c.h); ++y) {
+            for (int x = std::max(0, c.x); x < std::min(sheet->w, c.x + c.w); ++x) {
+                Uint8* p = pixel(x, y);
+                if (p[0] == CHARACTER_COLOR_KEY[0] && p[1] == CHARACTER_COLOR_KEY[1] && p[2] == CHARACTER_COLOR_KEY[2])
+                    p[0] = p[1] = p[2] = p[3] = 0;
+                if (p[3] == 0)
+                    continue;
+                minX = std::min(minX, x - c.x);
+                maxX = std::max(maxX, x - c.x);
+                minY = std::min(minY, y - c.y);
+                maxY = std::max(maxY, y - c.y);
+            }
+        }
+        trimmed[i] = maxX < 0 ? Cell{0, 0, 0, 0} : Cell{minX, minY, maxX - minX + 1, maxY - minY + 1};
+    }
+
+    // Shelf packing, tallest first, at the smallest width that keeps the atlas square-ish
+    std::vector<int> order(cells.size());
+    for (size_t i = 0; i < order.size(); ++i)
+        order[i] = static_cast<int>(i);
+    std::sort(order.begin(), order.end(), [&](int a, int b) { return trimmed[a].h > trimmed[b].h; });
+
+    std::vector<SDL_Rect> placed(cells.size());
+    int width = 1024, height = 0;
+    for (;; width *= 2) {
+        int x = 0, y = 0, shelf = 0;
+        for (const int i : order) {
+            const Cell& t = trimmed[i];
+            if (t.w == 0) {
+                placed[i] = {0, 0, 0, 0};
+                continue;
+            }
+            if (x + t.w + PADDING > width) {
+                x = 0;
+                y += shelf;
+                shelf = 0;
+            }
+            placed[i] = {x, y, t.w, t.h};
+            x += t.w + PADDING;
+            shelf = std::max(shelf, t.h + PADDING);
+        }
+        height = y + shelf;
+        if (height <= width || width >= MAX_ATLAS_SIZE)
+            break;
+    }
+    if (height > MAX_ATLAS_SIZE) {
+        std::fprintf(stderr, "%s does not fit in a %dx%d atlas\n", fighter.name, MAX_ATLAS_SIZE, MAX_ATLAS_SIZE);
+        SDL_DestroySurface(sheet);
+        return false;
+    }
+
+    SDL_Surface* atlas = SDL_CreateSurface(width, std::max(1, height), SDL_PIXELFORMAT_RGBA32);
+    if (!atlas) {
+        std::fprintf(stderr, "Failed to create atlas: %s\n", SDL_GetError());
+        SDL_DestroySurface(sheet);
+        return false;
+    }
+    std::memset(atlas->pixels, 0, static_cast<size_t>(atlas->pitch) * atlas->h);
+    for (size_t i = 0; i < cells.size(); ++i) {
+        const SDL_Rect& dst = placed[i];
+        for (int row = 0; row < dst.h; ++row)
+            std::memcpy(static_cast<Uint8*>(atlas->pixels) + (dst.y + row) * atlas->pitch + dst.x * 4,
+                        pixel(cells[i].x + trimmed[i].x, cells[i].y + trimmed[i].y + row),
+                        static_cast<size_t>(dst.w) * 4);
+    }
+    SDL_DestroySurface(sheet);
+
+    int colorCount = 0;
+    SDL_Surface* indexed = toIndexed(atlas, colorCount);
+    SDL_DestroySurface(atlas);
+    if (!indexed) {
+        std::fprintf(stderr, "Failed to index atlas: %s\n", SDL_GetError());
+        return false;
+    }
+
+    const std::string atlasPath = outDir + "/" + fighter.name + ".atlas.png";
+    const bool saved = IMG_SavePNG(indexed, atlasPath.c_str());
+    SDL_DestroySurface(indexed);
+    if (!saved) {
+        std::fprintf(stderr, "Failed to save %s: %s\n", atlasPath.c_str(), SDL_GetError());
+        return false;
+    }
+
+    const std::string tablePath = outDir + "/" + fighter.name + ".atlas";
+    std::ofstream table(tablePath);
+    table << ATLAS_TABLE_HEADER << '\n';
+    for (const Entry& e : entries) {
+        const SDL_Rect& r = placed[e.cell];
+        const Cell& t = trimmed[e.cell];
+        table << e.group << ' ' << e.index << ' ' << e.frame << ' '
+              << r.x << ' ' << r.y << ' ' << r.w << ' ' << r.h << ' '
+              << t.x << ' ' << t.y << ' ' << cells[e.cell].w << ' ' << cells[e.cell].h << '\n';
+    }
+    if (!table) {
+        std::fprintf(stderr, "Failed to write %s\n", tablePath.c_str());
+        return false;
+    }
+
+    std::printf("%s: %zu frames (%zu unique) into %dx%d, %d colors\n",
+                fighter.name, entries.size(), cells.size(), width, height, colorCount);
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "Usage: %s <raw res dir> <output dir>\n", argv[0]);
+        return 1;
+    }
+
+    bool ok = true;
+    for (const Fighter& fighter : FIGHTERS)
+        ok = cook(fighter, argv[1], argv[2]) && ok;
+    return ok ? 0 : 1;
+}
@@ -1,13 +1,16 @@
 #include "mortal_kombat_info.h"
 #include "mortal_kombat.h"
+#include <fstream>
 #include <iostream>
+#include <thread>
 #include <SDL3/SDL.h>
 #include <SDL3_image/SDL_image.h>
 #include <box2d/box2d.h>
 
 namespace mortal_kombat
 {
-    std::unordered_map<std::string, SDL_Texture*> MK::TextureSystem::textureCache;
+    std::deque<MK::TextureSystem::Entry> MK::TextureSystem::registry;
+    bagel::ThreadPool* MK::TextureSystem::loadPool = nullptr;
 
     void MK::start()
     {
@@ -23,37 +26,48 @@ namespace mortal_kombat
                 }
 
         SDL_SetRenderDrawColor(ren, 255,255,255,0);
+        // Only the render thread waits for it; the simulation keeps its own pace
+        SDL_SetRenderVSync(ren, 1);
 
         b2WorldDef worldDef = b2DefaultWorldDef();
         worldDef.gravity = {0,0};
+        physicsTasks.install(worldDef);
         boxWorld = b2CreateWorld(&worldDef);
 
+        bagel::World::reserve(MAX_ENTITIES, MAX_ENTITIES);
+        hits.reserve(2); // Two fighters can trade hits, no more
+
+        // Sheets decode concurrently on the pool while the window is already up
         createBackground("res/Background.png");
 
         createBoundary(LEFT);
         createBoundary(RIGHT);
-        bagel::Entity player1 = createPlayer(PLAYER_1_BASE_X, PLAYER_BASE_Y, Characters::SUBZERO, 1);
-        bagel::Entity player2 = createPlayer(PLAYER_2_BASE_X, PLAYER_BASE_Y, Characters::LIU_KANG, 2);
+        Character player1Character{&Characters::SUBZERO};
+        Character player2Character{&Characters::LIU_KANG};
+        // Like the arcade, a mirror match tells the fighters apart by palette
+        if (player1Character.data == player2Character.data)
+            player2Character.palette = PaletteSwap::YELLOW;
+
+        bagel::Entity player1 = createPlayer(PLAYER_1_BASE_X, PLAYER_BASE_Y, player1Character, 1);
+        bagel::Entity player2 = createPlayer(PLAYER_2_BASE_X, PLAYER_BASE_Y, player2Character, 2);
 
         createBar(player1, player2);
     }
 
     void MK::destroy() const
     {
-        for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id)
+        const bagel::View<Collider> view;
+        for (bagel::index_type i = view.size() - 1; i >= 0; --i)
         {
-            if (bagel::Entity entity{e}; entity.has<Collider>())
-            {
-                if (b2Body_IsValid(entity.get<Collider>().body)) {
-                    const auto* e_p = static_cast<bagel::ent_type*>(b2Body_GetUserData(entity.get<Collider>().body));
-                    b2DestroyBody(entity.get<Collider>().body);
-                    delete e_p;
-                }
-                entity.get<Collider>().body = b2_nullBodyId;
-                bagel::World::destroyEntity(e);
-            }
+            bagel::Entity entity = view[i];
+            if (b2Body_IsValid(entity.get<Collider>().body))
+                b2DestroyBody(entity.get<Collider>().body);
+            entity.get<Collider>().body = b2_nullBodyId;
+            entity.destroy();
         }
         TextureSystem::clearCache();
+        for (StaticLayerCache& cache : staticLayers)
+            cache.release();
         if (b2World_IsValid(boxWorld))
             b2DestroyWorld(boxWorld);
         if (ren != nullptr)
@@ -68,20 +82,66 @@ namespace mortal_kombat
 
     void MK::run() const
     {
+        // SDL keeps the window, its renderer and its events on this thread, so the
+        // simulation moves out; the two threads only meet in the triple buffers
+        std::thread simulation([this] { simulate(); });
+        while (RenderSystem()) {}
+
+        quit.store(true, std::memory_order_relaxed);
+        simulation.join();
+        exit(0);
+    }
+
+    void MK::simulate() const
+    {
+        bagel::World::Scope scope(world);
         int frame_count = 0;
-        while (true)
+
+        // Systems run in this order wherever their declared components overlap;
+        // the rest are spread over the pool. b2WorldId stands for the Box2D world.
+        bagel::Scheduler scheduler(pool);
+        scheduler.add([&] {
+                if (frame_count % INPUT_FRAME_DELAY == 0) {
+                    keyboard.update();
+                    InputSystem(keyboard.front());
+                }
+            })
+            .reads<PlayerState>().writes<Inputs>();
+        scheduler.add([&] { if (++frame_count % ACTION_FRAME_DELAY == 0) PlayerSystem(); })
+            .reads<Inputs, Character, Position, Health>()
+            .writes<PlayerState, Projectiles>();
+        // Same cadence as PlayerSystem, on the frames it just advanced to
+        scheduler.add([&] { if (frame_count % ACTION_FRAME_DELAY == 0) HitSystem(); })
+            .reads<Character, Position>()
+            .writes<PlayerState, Health>();
+        // Spawns recorded by PlayerSystem join the world before the physics step
+        scheduler.add(bagel::World::flush)
+            .exclusive().onMainThread();
+        scheduler.add(ClockSystem)
+            .writes<Time>();
+        scheduler.add([this] { CollisionSystem(); })
+            .reads<Boundary, PlayerState>()
+            .writes<b2WorldId, Collider>();
+        scheduler.add(MovementSystem)
+            .reads<Collider, Character>()
+            .writes<b2WorldId, Position, Movement, PlayerState>();
+        // After the fighters moved, so projectiles are tested against where they stand now
+        scheduler.add([this] { ProjectileSystem(); })
+            .reads<Character, Position>()
+            .writes<Projectiles, PlayerState, Health>();
+        scheduler.add([this] { SnapshotSystem(); })
+            .reads<Position, PlayerState, Character, Time, WinMessage, PendingTexture, RenderLayer, StaticLayer, Projectiles>()
+            .writes<Texture>();
+        scheduler.add(HealthBarSystem)
+            .reads<HealthBarReference, Health, Position>()
+            .writes<DamageVisual, Texture>();
+
+        while (!quit.load(std::memory_order_relaxed))
         {
             Uint32 frameStart = SDL_GetTicks();
 
-            if (frame_count % INPUT_FRAME_DELAY == 0) InputSystem();
-            if (++frame_count % ACTION_FRAME_DELAY == 0) PlayerSystem();
-            ClockSystem();
-            CollisionSystem();
-            SpecialAttackSystem();
-            MovementSystem();
-            RenderSystem();
-            HealthBarSystem();
-            AttackDecaySystem();
+            bagel::World::advance();
+            scheduler.run();
 
             if (Uint32 frameTime = SDL_GetTicks() - frameStart; FRAME_DELAY > frameTime) {
                 SDL_Delay(FRAME_DELAY - frameTime);
@@ -103,171 +163,157 @@ namespace mortal_kombat
         static constexpr float JUMP_HORIZONTAL_SPEED = 4.0f * SCALE_CHARACTER;
         static constexpr float FLOOR_Y = PLAYER_BASE_Y;  // Base floor position
 
-        static const bagel::Mask mask = bagel::MaskBuilder()
-            .set<Position>()
-            .set<Movement>()
-            .set<Collider>()
-            .build();
-
         static const bagel::Mask maskPlayer = bagel::MaskBuilder()
             .set<PlayerState>()
             .set<Character>()
             .build();
 
-        for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id)
+        for (bagel::Entity entity : bagel::View<Position, Movement, Collider>())
         {
-            if (bagel::Entity entity{e}; entity.test(mask))
+            const auto& position = entity.read<Position>();
+            auto& movement = entity.get<Movement>();
+            auto& collider = entity.get<Collider>();
+
+            if (entity.test(maskPlayer))
             {
-                auto& position = entity.get<Position>();
-                auto& movement = entity.get<Movement>();
-                auto& collider = entity.get<Collider>();
+                auto& playerState = entity.get<PlayerState>();
+                const CharacterData& character = *entity.read<Character>().data;
 
-                if (entity.test(maskPlayer))
+                switch (playerState.state)
                 {
-                    auto& playerState = entity.get<PlayerState>();
-                    auto& character = entity.get<Character>();
-
-                    switch (playerState.state)
-                    {
-                    case State::WALK_BACKWARDS:
-                        movement.vx = WALK_SPEED_BACKWARDS
-                                        * (playerState.direction == LEFT ? 1.0f : -1.0f)
-                                        * (collider.isRightBoundarySensor && playerState.direction == LEFT ? 0.0f : 1.0f)
-                                        * (collider.isLeftBoundarySensor && playerState.direction == RIGHT ? 0.0f : 1.0f);
-
-                        break;
-                    case State::WALK_FORWARDS:
-                        movement.vx = WALK_SPEED_FORWARDS
-                                        * (playerState.direction == LEFT ? -1.0f : 1.0f)
-                                        * (collider.isPlayerSensor ? 0.0f : 1.0f)
-                                        * (collider.isRightBoundarySensor && playerState.direction == RIGHT ? 0.0f : 1.0f)
-                                        * (collider.isLeftBoundarySensor && playerState.direction == LEFT ? 0.0f : 1.0f);
-;
-                        break;
-                    case State::KICKBACK_TORSO_HIT:
-                        movement.vx = KICKBACK_SPEED
-                                        * (playerState.direction == LEFT ? 1.0f : -1.0f);
-                        break;
-                    case State::JUMP:
-                        if (!playerState.isJumping) {
-                            playerState.isJumping = true;
-                            movement.vy = JUMP_INITIAL_VELOCITY;
-                        }
-                        movement.vx = 0; // Vertical jump - no horizontal movement
-                        break;
-                    case State::JUMP_BACK:
-                        if (!playerState.isJumping) {
-                            playerState.isJumping = true;
-                            movement.vy = JUMP_INITIAL_VELOCITY;
-                        }
-                        movement.vx = JUMP_HORIZONTAL_SPEED
+                case State::WALK_BACKWARDS:
+                    movement.vx = WALK_SPEED_BACKWARDS
                                     * (playerState.direction == LEFT ? 1.0f : -1.0f)
                                     * (collider.isRightBoundarySensor && playerState.direction == LEFT ? 0.0f : 1.0f)
                                     * (collider.isLeftBoundarySensor && playerState.direction == RIGHT ? 0.0f : 1.0f);
-                        break;
-                    case State::ROLL:
-                        // Forward jump
-                        if (!playerState.isJumping) {
-                            playerState.isJumping = true;
-                            movement.vy = JUMP_INITIAL_VELOCITY;
-                        }
-                        movement.vx = JUMP_HORIZONTAL_SPEED
+
+                    break;
+                case State::WALK_FORWARDS:
+                    movement.vx = WALK_SPEED_FORWARDS
                                     * (playerState.direction == LEFT ? -1.0f : 1.0f)
+                                    * (collider.isPlayerSensor ? 0.0f : 1.0f)
                                     * (collider.isRightBoundarySensor && playerState.direction == RIGHT ? 0.0f : 1.0f)
                                     * (collider.isLeftBoundarySensor && playerState.direction == LEFT ? 0.0f : 1.0f);
-                        break;
-                    case State::UPPERCUT_HIT:
-                        if (playerState.currFrame < character.sprite[playerState.state].frameCount / 2)
-                        {
-                            movement.vx = FALL_SPEED
-                                        * (playerState.direction == LEFT ? 1.0f : -1.0f);
-                            break;
-                        }
-                        movement.reset();
-                        break;
-                    default:
-                        if (!playerState.isJumping)
-                            movement.reset();
+;
+                    break;
+                case State::KICKBACK_TORSO_HIT:
+                    movement.vx = KICKBACK_SPEED
+                                    * (playerState.direction == LEFT ? 1.0f : -1.0f);
+                    break;
+                case State::JUMP:
+                    if (!playerState.isJumping) {
+                        playerState.isJumping = true;
+                        movement.vy = JUMP_INITIAL_VELOCITY;
+                    }
+                    movement.vx = 0; // Vertical jump - no horizontal movement
+                    break;
+                case State::JUMP_BACK:
+                    if (!playerState.isJumping) {
+                        playerState.isJumping = true;
+                        movement.vy = JUMP_INITIAL_VELOCITY;
+                    }
+                    movement.vx = JUMP_HORIZONTAL_SPEED
+                                * (playerState.direction == LEFT ? 1.0f : -1.0f)
+                                * (collider.isRightBoundarySensor && playerState.direction == LEFT ? 0.0f : 1.0f)
+                                * (collider.isLeftBoundarySensor && playerState.direction == RIGHT ? 0.0f : 1.0f);
+                    break;
+                case State::ROLL:
+                    // Forward jump
+                    if (!playerState.isJumping) {
+                        playerState.isJumping = true;
+                        movement.vy = JUMP_INITIAL_VELOCITY;
+                    }
+                    movement.vx = JUMP_HORIZONTAL_SPEED
+                                * (playerState.direction == LEFT ? -1.0f : 1.0f)
+                                * (collider.isRightBoundarySensor && playerState.direction == RIGHT ? 0.0f : 1.0f)
+                                * (collider.isLeftBoundarySensor && playerState.direction == LEFT ? 0.0f : 1.0f);
+                    break;
+                case State::UPPERCUT_HIT:
+                    if (playerState.currFrame < character.sprite[playerState.state].frameCount / 2)
+                    {
+                        movement.vx = FALL_SPEED
+                                    * (playerState.direction == LEFT ? 1.0f : -1.0f);
                         break;
                     }
+                    movement.reset();
+                    break;
+                default:
+                    if (!playerState.isJumping)
+                        movement.reset();
+                    break;
+                }
 
-                    // Apply gravity and handle jumping physics
-                    if (playerState.isJumping)
-                    {
-                        // Apply gravity to vertical velocity
-                        movement.vy += GRAVITY;
-
-                        // Check if player has landed
-                        if (position.y + movement.vy >= FLOOR_Y) {
-                            position.y = FLOOR_Y;
-                            movement.vy = 0;
-                            playerState.isJumping = false;
-
-                            // Change state to landing animation when landing
-                            if (playerState.state == State::JUMP ||
-                                playerState.state == State::JUMP_BACK ||
-                                playerState.state == State::ROLL ||
-                                playerState.state == State::JUMP_PUNCH ||
-                                playerState.state == State::JUMP_HIGH_KICK ||
-                                playerState.state == State::JUMP_LOW_KICK)
-                            {
-                                playerState.reset();
-                                playerState.state = State::LANDING;
-                                playerState.currFrame = 0;
-                                playerState.busy = true;
-                                playerState.busyFrames = character.sprite[State::LANDING].frameCount;
-                            }
+                // Apply gravity and handle jumping physics
+                if (playerState.isJumping)
+                {
+                    // Apply gravity to vertical velocity
+                    movement.vy += GRAVITY;
+
+                    // Check if player has landed
+                    if (position.y + movement.vy >= FLOOR_Y) {
+                        entity.get<Position>().y = FLOOR_Y;
+                        movement.vy = 0;
+                        playerState.isJumping = false;
+
+                        // Change state to landing animation when landing
+                        if (playerState.state == State::JUMP ||
+                            playerState.state == State::JUMP_BACK ||
+                            playerState.state == State::ROLL ||
+                            playerState.state == State::JUMP_PUNCH ||
+                            playerState.state == State::JUMP_HIGH_KICK ||
+                            playerState.state == State::JUMP_LOW_KICK)
+                        {
+                            playerState.reset();
+                            playerState.state = State::LANDING;
+                            playerState.currFrame = 0;
+                            playerState.busy = true;
+                            playerState.busyFrames = character.sprite[State::LANDING].frameCount;
                         }
                     }
                 }
+            }
 
-                position.x += movement.vx;
-                position.y += movement.vy;
+            // Resting entities are not written, so they keep their old change tick
+            if (movement.vx != 0 || movement.vy != 0)
+            {
+                auto& moved = entity.get<Position>();
+                moved.x += movement.vx;
+                moved.y += movement.vy;
+            }
+        }
 
-                if (entity.has<PlayerState>() && entity.get<PlayerState>().isCrouching)
-                {
-                    b2Body_SetTransform(
-                            collider.body,
-                            getPosition(position.x, position.y - (CHARACTER_HEIGHT/2.0f)),
-                            b2Rot_identity);
-                }
-                else if (entity.has<SpecialAttack>())
-                {
-                    auto& sprite = entity.get<Character>().specialAttackSprite[entity.get<SpecialAttack>().type];
-                    b2Body_SetTransform(
-                            collider.body,
-                            getPosition(position.x - sprite.w, position.y - entity.get<Character>().specialAttackOffset_y + (sprite.h / 2.0f)), // NOLINT(*-narrowing-conversions)
-                            b2Rot_identity);
-                }
-                else
-                {
-                    b2Body_SetTransform(
-                              collider.body,
-                              getPosition(position),
-                              b2Rot_identity);
-                }
+        // Sync Box2D only for bodies that moved (or changed crouch) since the last frame
+        const bagel::tick_type since = bagel::World::tick() - 1;
+        for (bagel::Entity entity : bagel::View<Position, Movement, Collider>().changedSince<Position, PlayerState>(since))
+        {
+            const auto& position = entity.read<Position>();
+            const auto& collider = entity.get<Collider>();
+
+            if (entity.has<PlayerState>() && entity.read<PlayerState>().isCrouching)
+            {
+                b2Body_SetTransform(
+                        collider.body,
+                        getPosition(position.x, position.y - (CHARACTER_HEIGHT/2.0f)),
+                        b2Rot_identity);
+            }
+            else
+            {
+                b2Body_SetTransform(
+                          collider.body,
+                          getPosition(position),
+                          b2Rot_identity);
             }
         }
     }
 
-    void MK::RenderSystem() const
+    void MK::SnapshotSystem() const
     {
-        static const bagel::Mask mask = bagel::MaskBuilder()
-            .set<Position>()
-            .set<Texture>()
-            .build();
-
         static const bagel::Mask maskPlayer = bagel::MaskBuilder()
             .set<PlayerState>()
             .set<Health>()
             .set<Character>()
             .build();
 
-        static const bagel::Mask maskSpecialAttack = bagel::MaskBuilder()
-            .set<SpecialAttack>()
-            .set<Character>()
-            .build();
-
         static const bagel::Mask maskWin = bagel::MaskBuilder()
             .set<Position>()
             .set<WinMessage>()
@@ -275,118 +321,377 @@ namespace mortal_kombat
             .set<Time>()
             .build();
 
-        SDL_Event event;
+        RenderSnapshot& snapshot = snapshots.back();
+        snapshot.sprites.clear();
 
-        while (SDL_PollEvent(&event)) {
-            if (event.type == SDL_EVENT_QUIT) {
-                exit(0);
-            }
-        }
-        SDL_RenderClear(ren);
+        // Rects are only recomputed for sprites whose inputs changed since the last frame;
+        // the background and bars keep the rects they were created with
+        const bagel::tick_type since = bagel::World::tick() - 1;
 
-        for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id)
+        for (bagel::Entity entity : bagel::View<Position, Texture>())
         {
-            if (bagel::Entity entity{e}; entity.test(mask))
+            SDL_FlipMode flipMode = SDL_FLIP_NONE;
+            bool placed = false; // Atlas frames place their own trimmed rect
+
+            const auto& position = entity.read<Position>();
+            auto& texture = entity.get<Texture>();
+            bool changed = entity.changedSince<Position, PlayerState, Time>(since);
+
+            if (entity.has<PendingTexture>())
             {
-                SDL_FlipMode flipMode = SDL_FLIP_NONE;
+                const auto& pending = entity.read<PendingTexture>();
+                if (!TextureSystem::decoded(pending.handle))
+                    continue;
+
+                texture.atlas = TextureSystem::atlas(pending.handle);
+                texture.palette = texture.atlas ? texture.atlas->palette(pending.palette) : nullptr;
+                texture.handle = pending.handle;
+                bagel::World::commands().del<PendingTexture>(entity.entity());
+                changed = true;
+            }
 
-                auto& position = entity.get<Position>();
-                auto& texture = entity.get<Texture>();
+            if (entity.test(maskPlayer)) {
+                const auto& playerState = entity.read<PlayerState>();
+                const CharacterData& character = *entity.read<Character>().data;
 
-                if (entity.test(maskPlayer)) {
-                    auto& playerState = entity.get<PlayerState>();
-                    auto& character = entity.get<Character>();
+                flipMode = (playerState.direction == LEFT) ?
+                    SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
 
+                if (changed)
+                {
                     const int frame = (playerState.state == State::WALK_BACKWARDS)
                         ? (playerState.busyFrames - (playerState.currFrame % playerState.busyFrames)): (playerState.currFrame);
 
-                    flipMode = (playerState.direction == LEFT) ?
-                        SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-
-                    texture.srcRect = getSpriteFrame(character, playerState.state, frame);
-                    texture.rect.w = static_cast<float>((character.sprite[playerState.state].w)) * SCALE_CHARACTER;
-                    texture.rect.h = static_cast<float>((character.sprite[playerState.state].h)) * SCALE_CHARACTER;
-                }
-                else if (entity.test(maskSpecialAttack))
-                {
-                    auto& specialAttack = entity.get<SpecialAttack>();
-                    auto& character = entity.get<Character>();
-                    flipMode = (specialAttack.direction == LEFT) ?
-                        SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
-
-                    texture.srcRect = getSpriteFrame(character, specialAttack.type, specialAttack.frame);
-                    texture.rect.w = static_cast<float>((character.specialAttackSprite[specialAttack.type].w)) * SCALE_CHARACTER;
-                    texture.rect.h = static_cast<float>((character.specialAttackSprite[specialAttack.type].h)) * SCALE_CHARACTER;
-                }
-                else if (entity.test(maskWin))
-                {
-                    auto& character = entity.get<Character>();
-                    texture.srcRect = getWinSpriteFrame(character, (static_cast<int>(entity.get<Time>().time) / 16));
-                    texture.rect.w = static_cast<float>((character.winText.w)) * SCALE_CHARACTER;
-                    texture.rect.h = static_cast<float>((character.winText.h)) * SCALE_CHARACTER;
+                    if (texture.atlas)
+                    {
+                        setAtlasFrame(texture, texture.atlas->frame(playerState.state, frame), position,
+                                      character.sprite[playerState.state].w, character.sprite[playerState.state].h, flipMode);
+                        placed = true;
+                    }
+                    else
+                    {
+                        texture.srcRect = getSpriteFrame(character, playerState.state, frame);
+                        texture.rect.w = static_cast<float>((character.sprite[playerState.state].w)) * SCALE_CHARACTER;
+                        texture.rect.h = static_cast<float>((character.sprite[playerState.state].h)) * SCALE_CHARACTER;
+                    }
                 }
+            }
+            else if (entity.test(maskWin) && changed)
+            {
+                const CharacterData& character = *entity.read<Character>().data;
+                texture.srcRect = getWinSpriteFrame(character, (static_cast<int>(entity.read<Time>().time) / 16));
+                texture.rect.w = static_cast<float>((character.winText.w)) * SCALE_CHARACTER;
+                texture.rect.h = static_cast<float>((character.winText.h)) * SCALE_CHARACTER;
+            }
 
+            if (changed && !placed)
+            {
                 texture.rect.x = position.x;
                 texture.rect.y = position.y;
+            }
+
+            const Uint32 key = RenderQueue::keyOf(
+                entity.has<RenderLayer>() ? entity.read<RenderLayer>() : RenderLayer{}, texture);
+            const StaticCache cache = entity.has<StaticLayer>() ? entity.read<StaticLayer>().cache : StaticCache::COUNT;
+            snapshot.sprites.push_back({key, entity.entity(), texture.handle, texture.palette,
+                                        texture.srcRect, texture.rect, flipMode, cache});
+        }
 
-                SDL_RenderTextureRotated(
-                    ren, texture.tex, &texture.srcRect, &texture.rect, 0,
-                    nullptr, flipMode);
+        // Projectiles all move every tick, so their rects are always rebuilt; what they are
+        // drawn with is resolved once per shooter. Sharing a key, they sort into one batch
+        struct Resolved {
+            const SpriteAtlas* atlas = nullptr;
+            SDL_Palette* palette = nullptr;
+            Uint32 key = 0;
+            bool ready = false;
+        };
+        std::array<Resolved, 3> shooters{};
+        for (int player = 1; player <= 2; ++player)
+        {
+            const Projectiles::Shooter& shooter = projectiles.shooter(player);
+            if (shooter.texture == NONE || !TextureSystem::decoded(shooter.texture))
+                continue;
+            Texture texture;
+            texture.handle = shooter.texture;
+            Resolved& resolved = shooters[player];
+            resolved.atlas = TextureSystem::atlas(shooter.texture);
+            resolved.palette = resolved.atlas ? resolved.atlas->palette(shooter.palette) : nullptr;
+            resolved.key = RenderQueue::keyOf(RenderLayer{Layer::PROJECTILES}, texture);
+            resolved.ready = true;
+        }
+
+        projectiles.each([&](const Projectiles::Sprite& projectile) {
+            const Resolved& resolved = shooters[projectile.playerNumber];
+            if (!resolved.ready)
+                return;
+            const Projectiles::Shooter& shooter = projectiles.shooter(projectile.playerNumber);
+            const SpriteInfo& sprite = shooter.data->specialAttackSprite[projectile.type];
+            const SDL_FlipMode flipMode = (projectile.direction == LEFT) ? SDL_FLIP_HORIZONTAL : SDL_FLIP_NONE;
+
+            Texture texture;
+            if (resolved.atlas)
+            {
+                setAtlasFrame(texture, resolved.atlas->frame(projectile.type, projectile.frame),
+                              Position{projectile.x, projectile.y}, sprite.w, sprite.h, flipMode);
+            }
+            else
+            {
+                texture.srcRect = getSpriteFrame(*shooter.data, projectile.type, projectile.frame);
+                texture.rect = {projectile.x, projectile.y, sprite.w * SCALE_CHARACTER, sprite.h * SCALE_CHARACTER};
+            }
+            snapshot.sprites.push_back({resolved.key, bagel::ent_type{}, shooter.texture, resolved.palette,
+                                        texture.srcRect, texture.rect, flipMode, StaticCache::COUNT});
+        });
+
+        snapshots.publish();
+    }
+
+    bool MK::RenderSystem() const
+    {
+        SDL_Event event;
+
+        while (SDL_PollEvent(&event)) {
+            if (event.type == SDL_EVENT_QUIT) {
+                return false;
             }
         }
 
+        int keyCount = 0;
+        const bool* keys = SDL_GetKeyboardState(&keyCount);
+        if (keys[SDL_SCANCODE_ESCAPE]) {
+            return false;
+        }
+        KeyboardState& keyboardState = keyboard.back();
+        std::copy_n(keys, std::min<size_t>(keyCount, keyboardState.size()), keyboardState.begin());
+        keyboard.publish();
+
+        // Creates the textures whose decode finished on the pool since the last frame
+        TextureSystem::uploadLoaded(ren);
+
+        // The simulation has not ticked since the last frame; keep polling without redrawing it
+        if (!snapshots.update()) {
+            SDL_Delay(1);
+            return true;
+        }
+        SDL_RenderClear(ren);
+
+        const RenderSnapshot& snapshot = snapshots.front();
+        drawn.clear();
+        drawn.reserve(snapshot.sprites.size()); // The queue and the caches point into it
+        for (const RenderSnapshot::Sprite& sprite : snapshot.sprites)
+        {
+            const Texture* loaded = (sprite.handle == NONE) ? nullptr : TextureSystem::loaded(sprite.handle);
+            if (!loaded)
+                continue; // Decoded, but not uploaded yet
+
+            const Texture& texture = drawn.emplace_back(
+                Texture{loaded->tex, sprite.srcRect, sprite.rect, loaded->atlas, sprite.palette, sprite.handle});
+            if (sprite.cache != StaticCache::COUNT)
+                staticLayers[static_cast<int>(sprite.cache)].add(sprite.entity, sprite.key, texture);
+            else
+                renderQueue.push(sprite.key, texture, sprite.flipMode);
+        }
+
+        for (StaticLayerCache& cache : staticLayers)
+        {
+            if (cache.update(ren, spriteBatch))
+                renderQueue.push(cache.key(), cache.texture(), SDL_FLIP_NONE);
+            cache.begin();
+        }
+
+        for (const RenderQueue::Item& item : renderQueue.sort())
+            spriteBatch.add(ren, item.texture->tex, item.texture->palette, item.texture->srcRect, item.texture->rect,
+                            item.flipMode);
+        renderQueue.clear();
+
+        spriteBatch.flush(ren);
         SDL_RenderPresent(ren);
+        return true;
     }
 
-    SDL_FRect MK::getSpriteFrame(const Character& character, State action, const int frame,
-                                               const bool shadow)
+    Uint32 MK::RenderQueue::keyOf(const RenderLayer& layer, const Texture& texture)
     {
-        return {static_cast<float>(character.sprite[action].x
-                    + ((frame % character.sprite[(action)].frameCount)
-                    * (NEXT_FRAME_OFFSET + character.sprite[action].w))) + 1
-                ,static_cast<float>(character.sprite[action].y
-                    + (shadow ? (SHADOW_OFFSET + character.sprite[action].h) : 0)) + 1
-                ,static_cast<float>(character.sprite[action].w) - 2
-                ,static_cast<float>(character.sprite[action].h) - 2};
+        // NONE sorts first
+        return (static_cast<Uint32>(layer.layer) << 28)
+             | ((static_cast<Uint32>(texture.handle + 1) & 0xFFF) << 16)
+             | layer.z;
     }
 
-    SDL_FRect MK::getSpriteFrame(const Character& character, SpecialAttacks action, int frame)
+    void MK::StaticLayerCache::begin()
     {
-        return {static_cast<float>(character.specialAttackSprite[action].x
-                    + ((frame % character.specialAttackSprite[(action)].frameCount)
-                    * (NEXT_FRAME_OFFSET + character.specialAttackSprite[action].w))) + 1
-                ,static_cast<float>(character.specialAttackSprite[action].y) + 1
-                ,static_cast<float>(character.specialAttackSprite[action].w) - 2
-                ,static_cast<float>(character.specialAttackSprite[action].h) - 2};
+        members.clear();
+        signature = FNV_OFFSET_BASIS;
     }
 
-    SDL_FRect MK::getWinSpriteFrame(const Character& character, const int frame)
+    void MK::StaticLayerCache::add(const bagel::ent_type entity, const Uint32 key, const Texture& texture)
     {
-        return {static_cast<float>(character.winText.x
-                    + ((frame % character.winText.frameCount)
-                    * (NEXT_FRAME_OFFSET + character.winText.w))) + 2
-                ,static_cast<float>(character.winText.y) + 2
-                ,static_cast<float>(character.winText.w) - 4
-                ,static_cast<float>(character.winText.h) - 4};
+        if (members.empty() || key < first)
+            first = key;
+        members.push_back({key, &texture});
+
+        // Anything that would change the composite goes into the signature
+        const auto mix = [this](const void* data, const size_t size) {
+            for (size_t i = 0; i < size; ++i)
+                signature = (signature ^ static_cast<const Uint8*>(data)[i]) * 1099511628211ull;
+        };
+        mix(&entity.id, sizeof(entity.id));
+        mix(&key, sizeof(key));
+        mix(&texture.tex, sizeof(texture.tex));
+        mix(&texture.palette, sizeof(texture.palette));
+        mix(&texture.srcRect, sizeof(texture.srcRect));
+        mix(&texture.rect, sizeof(texture.rect));
     }
 
-    void MK::PlayerSystem() const
+    bool MK::StaticLayerCache::update(SDL_Renderer* renderer, SpriteBatch& batch)
     {
-        static const bagel::Mask mask = bagel::MaskBuilder()
-            .set<Inputs>()
-            .set<PlayerState>()
-            .set<Character>()
-            .build();
+        if (members.empty())
+            return false;
+        if (composite.tex && signature == builtSignature)
+            return true;
+
+        if (!composite.tex)
+        {
+            composite.tex = SDL_CreateTexture(renderer, SDL_PIXELFORMAT_RGBA32, SDL_TEXTUREACCESS_TARGET,
+                                              WINDOW_WIDTH, WINDOW_HEIGHT);
+            if (!composite.tex)
+            {
+                SDL_Log("Failed to create static layer target: %s", SDL_GetError());
+                return false;
+            }
+            // Drawing straight-alpha sprites onto a transparent target leaves premultiplied color
+            SDL_SetTextureBlendMode(composite.tex, SDL_BLENDMODE_BLEND_PREMULTIPLIED);
+            composite.srcRect = composite.rect = {0, 0, WINDOW_WIDTH, WINDOW_HEIGHT};
+        }
+
+        std::stable_sort(members.begin(), members.end(),
+                         [](const Member& a, const Member& b) { return a.key < b.key; });
+
+        Uint8 r, g, b, a;
+        SDL_GetRenderDrawColor(renderer, &r, &g, &b, &a);
+        SDL_SetRenderTarget(renderer, composite.tex);
+        SDL_SetRenderDrawColor(renderer, 0, 0, 0, 0);
+        SDL_RenderClear(renderer);
+        for (const Member& member : members)
+            batch.add(renderer, member.texture->tex, member.texture->palette, member.texture->srcRect,
+                      member.texture->rect, SDL_FLIP_NONE);
+        batch.flush(renderer);
+        SDL_SetRenderTarget(renderer, nullptr);
+        SDL_SetRenderDrawColor(renderer, r, g, b, a);
+
+        builtSignature = signature;
+        return true;
+    }
 
+    void MK::StaticLayerCache::release()
+    {
+        if (composite.tex)
+            SDL_DestroyTexture(composite.tex);
+        composite.tex = nullptr;
+        builtSignature = 0;
+    }
+
+    const std::vector<MK::RenderQueue::Item>& MK::RenderQueue::sort()
+    {
+        scratch.resize(items.size());
+        for (int shift = 0; shift < 32; shift += 8)
+        {
+            size_t offsets[257] = {};
+            for (const Item& item : items)
+                ++offsets[((item.key >> shift) & 0xFF) + 1];
+
+            // Every key shares this byte; the pass would not move anything
+            if (offsets[((items.empty() ? 0 : items[0].key >> shift) & 0xFF) + 1] == items.size())
+                continue;
+
+            for (int i = 1; i < 257; ++i)
+                offsets[i] += offsets[i - 1];
+            for (const Item& item : items)
+                scratch[offsets[(item.key >> shift) & 0xFF]++] = item;
+            items.swap(scratch);
+        }
+        return items;
+    }
+
+    void MK::SpriteBatch::add(SDL_Renderer* renderer, SDL_Texture* tex, SDL_Palette* pal, const SDL_FRect& src,
+                              const SDL_FRect& dst, const SDL_FlipMode flipMode)
+    {
+        if (!tex || dst.w <= 0 || dst.h <= 0)
+            return;
+        if (tex != texture || pal != palette)
+        {
+            flush(renderer);
+            texture = tex;
+            palette = pal;
+        }
+
+        const float texW = static_cast<float>(tex->w);
+        const float texH = static_cast<float>(tex->h);
+        float u0 = src.x / texW, u1 = (src.x + src.w) / texW;
+        const float v0 = src.y / texH, v1 = (src.y + src.h) / texH;
+        if (flipMode == SDL_FLIP_HORIZONTAL)
+            std::swap(u0, u1);
+
+        constexpr SDL_FColor WHITE = {1, 1, 1, 1};
+        const int base = static_cast<int>(vertices.size());
+        vertices.push_back({{dst.x, dst.y}, WHITE, {u0, v0}});
+        vertices.push_back({{dst.x + dst.w, dst.y}, WHITE, {u1, v0}});
+        vertices.push_back({{dst.x + dst.w, dst.y + dst.h}, WHITE, {u1, v1}});
+        vertices.push_back({{dst.x, dst.y + dst.h}, WHITE, {u0, v1}});
+        for (const int i : {0, 1, 2, 2, 3, 0})
+            indices.push_back(base + i);
+    }
+
+    void MK::SpriteBatch::flush(SDL_Renderer* renderer)
+    {
+        if (!indices.empty())
+        {
+            // A palette swap retargets the whole texture, so draws queued under the
+            // previous palette have to reach the GPU first
+            if (palette && texture->format == SDL_PIXELFORMAT_INDEX8 && SDL_GetTexturePalette(texture) != palette)
+            {
+                SDL_FlushRenderer(renderer);
+                SDL_SetTexturePalette(texture, palette);
+            }
+            SDL_RenderGeometry(renderer, texture, vertices.data(), static_cast<int>(vertices.size()),
+                               indices.data(), static_cast<int>(indices.size()));
+        }
+        vertices.clear();
+        indices.clear();
+        texture = nullptr;
+        palette = nullptr;
+    }
+
+    void MK::setAtlasFrame(Texture& texture, const AtlasFrame& frame, const Position& position,
+                           const float w, const float h, const SDL_FlipMode flipMode)
+    {
+        texture.srcRect = {frame.x, frame.y, frame.w, frame.h};
+        if (frame.cellW <= 0 || frame.cellH <= 0)
+        {
+            texture.rect = {position.x, position.y, 0, 0};
+            return;
+        }
+
+        // The raw sheets stretch the cell (1px border dropped) over the whole sprite; keep that scale
+        const float scaleX = w * SCALE_CHARACTER / frame.cellW;
+        const float scaleY = h * SCALE_CHARACTER / frame.cellH;
+        const float offsetX = (flipMode == SDL_FLIP_HORIZONTAL)
+            ? frame.cellW - frame.offsetX - frame.w : frame.offsetX;
+
+        texture.rect = {position.x + offsetX * scaleX, position.y + frame.offsetY * scaleY,
+                        frame.w * scaleX, frame.h * scaleY};
+    }
+
+    void MK::PlayerSystem() const
+    {
         bagel::ent_type player1Entity{}, player2Entity{};
         bool foundPlayer1 = false, foundPlayer2 = false;
 
         // Helper lambda to map inputs to state
-        auto getStateFromInputs = [](const Inputs& inputs, const Character& character, State& state, int& freezeFrame,
+        auto getStateFromInputs = [](const Inputs& inputs, const CharacterData& character, State& state, int& freezeFrame,
                                      int& freezeFrameDuration, bool& busy, bool& crouching, bool& attack, bool& special,
                                      bool& jumping)
         {
-            for (int i = 0; i < Character::SPECIAL_ATTACKS_COUNT && !special; ++i)
+            for (int i = 0; i < CharacterData::SPECIAL_ATTACKS_COUNT && !special; ++i)
             {
                 if (inputs == character.specialAttacks[i]
                         || inputs == character.specialAttacks[i + 1])
@@ -519,84 +824,77 @@ namespace mortal_kombat
             }
         };
 
-        for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id)
+        for (bagel::Entity entity : bagel::View<Inputs, PlayerState, Character>())
         {
-            if (bagel::Entity entity{e}; entity.test(mask))
-            {
-                auto& inputs = entity.get<Inputs>();
-                auto& playerState = entity.get<PlayerState>();
-                auto& character = entity.get<Character>();
+            auto& inputs = entity.get<Inputs>();
+            auto& playerState = entity.get<PlayerState>();
+            const CharacterData& character = *entity.read<Character>().data;
 
-                if (playerState.playerNumber == 1) { player1Entity = e; foundPlayer1 = true; }
-                else if (playerState.playerNumber == 2) { player2Entity = e; foundPlayer2 = true; }
+            if (playerState.playerNumber == 1) { player1Entity = entity.entity(); foundPlayer1 = true; }
+            else if (playerState.playerNumber == 2) { player2Entity = entity.entity(); foundPlayer2 = true; }
 
-                // State variables
-                State state = State::STANCE;
-                int freezeFrame = NONE, freezeFrameDuration = 0;
-                bool busy = true, crouching = false, attack = false, special = false, jumping = false;
+            // State variables
+            State state = State::STANCE;
+            int freezeFrame = NONE, freezeFrameDuration = 0;
+            bool busy = true, crouching = false, attack = false, special = false, jumping = false;
 
-                // Use helper to determine state and flags
-                getStateFromInputs(inputs, character, state, freezeFrame,
-                                    freezeFrameDuration, busy, crouching,
-                                    attack, special, jumping);
+            // Use helper to determine state and flags
+            getStateFromInputs(inputs, character, state, freezeFrame,
+                                freezeFrameDuration, busy, crouching,
+                                attack, special, jumping);
 
-                // Handle busy state and transitions
-                if (playerState.busyFrames - 1 <= playerState.currFrame && playerState.freezeFrameDuration <= 0)
-                    playerState.busy = false;
+            // Handle busy state and transitions
+            if (playerState.busyFrames - 1 <= playerState.currFrame && playerState.freezeFrameDuration <= 0)
+                playerState.busy = false;
 
-                if (playerState.isLaying && !playerState.busy)
-                {
-                    playerState.reset();
-                    playerState.state = State::GETUP;
-                    playerState.busyFrames = character.sprite[playerState.state].frameCount;
-                    playerState.busy = true;
-                }
+            if (playerState.isLaying && !playerState.busy)
+            {
+                playerState.reset();
+                playerState.state = State::GETUP;
+                playerState.busyFrames = character.sprite[playerState.state].frameCount;
+                playerState.busy = true;
+            }
 
-                // State change logic
-                bool shouldChangeState = ((!playerState.busy && (state != playerState.state || attack))
-                    || (playerState.state == State::CROUCH && crouching && state != State::CROUCH))
-                    && (!playerState.isJumping || jumping);
+            // State change logic
+            bool shouldChangeState = ((!playerState.busy && (state != playerState.state || attack))
+                || (playerState.state == State::CROUCH && crouching && state != State::CROUCH))
+                && (!playerState.isJumping || jumping);
 
-                if (shouldChangeState)
-                {
-                    playerState.reset();
-                    playerState.state = state;
-                    playerState.currFrame = (playerState.isCrouching && state == State::CROUCH) ? 2 : 0;
-                    playerState.busyFrames = character.sprite[playerState.state].frameCount;
-                    playerState.freezeFrame = freezeFrame;
-                    playerState.freezeFrameDuration = freezeFrameDuration;
-                    playerState.isJumping = jumping;
-                    playerState.isCrouching = crouching;
-                    playerState.isAttacking = attack;
-                    playerState.isSpecialAttack = special;
-                    playerState.busy = busy;
-                }
+            if (shouldChangeState)
+            {
+                playerState.reset();
+                playerState.state = state;
+                playerState.currFrame = (playerState.isCrouching && state == State::CROUCH) ? 2 : 0;
+                playerState.busyFrames = character.sprite[playerState.state].frameCount;
+                playerState.freezeFrame = freezeFrame;
+                playerState.freezeFrameDuration = freezeFrameDuration;
+                playerState.isJumping = jumping;
+                playerState.isCrouching = crouching;
+                playerState.isAttacking = attack;
+                playerState.isSpecialAttack = special;
+                playerState.busy = busy;
+            }
 
-                // Freeze frame logic
-                if (playerState.freezeFrame != NONE && state == playerState.state)
-                    ++playerState.freezeFrameDuration;
+            // Freeze frame logic
+            if (playerState.freezeFrame != NONE && state == playerState.state)
+                ++playerState.freezeFrameDuration;
 
-                if (playerState.freezeFrame != NONE
-                    && playerState.currFrame + 1 >= playerState.freezeFrame
-                    && playerState.freezeFrameDuration > 0)
-                {
-                    --playerState.freezeFrameDuration;
-                    playerState.currFrame = playerState.freezeFrame;
-                }
-                else if (!playerState.isJumping || playerState.currFrame < playerState.busyFrames-1)
-                    ++playerState.currFrame;
+            if (playerState.freezeFrame != NONE
+                && playerState.currFrame + 1 >= playerState.freezeFrame
+                && playerState.freezeFrameDuration > 0)
+            {
+                --playerState.freezeFrameDuration;
+                playerState.currFrame = playerState.freezeFrame;
+            }
+            else if (!playerState.isJumping || playerState.currFrame < playerState.busyFrames-1)
+                ++playerState.currFrame;
 
-                // Attack creation
-                if (playerState.busy && playerState.isAttacking)
-                {
-                    auto& [x, y] = entity.get<Position>();
-                    if (playerState.isSpecialAttack
-                        && (playerState.currFrame % character.sprite[playerState.state].frameCount) == character.sprite[playerState.state].frameCount / 2)
-                        createSpecialAttack(x, y, SpecialAttacks::FIREBALL, playerState.playerNumber, playerState.direction, character);
-                    else if (playerState.isJumping
-                            || (playerState.currFrame % character.sprite[playerState.state].frameCount) == character.sprite[playerState.state].frameCount / 3)
-                        createAttack(x, y, playerState.state, playerState.playerNumber, playerState.direction);
-                }
+            // Projectile creation; melee hits come from the frame data, see HitSystem
+            if (playerState.busy && playerState.isAttacking && playerState.isSpecialAttack
+                && (playerState.currFrame % character.sprite[playerState.state].frameCount) == character.sprite[playerState.state].frameCount / 2)
+            {
+                const auto& [x, y] = entity.read<Position>();
+                projectiles.spawn(x, y, SpecialAttacks::FIREBALL, playerState.playerNumber, playerState.direction);
             }
         }
 
@@ -604,21 +902,21 @@ namespace mortal_kombat
         if (foundPlayer1 && foundPlayer2) {
             bagel::Entity player1{player1Entity};
             bagel::Entity player2{player2Entity};
-            auto& p1State = player1.get<PlayerState>();
-            auto& p2State = player2.get<PlayerState>();
-            auto& p1Health = player1.get<Health>();
-            auto& p2Health = player2.get<Health>();
-            auto& p1Char = player1.get<Character>();
-            auto& p2Char = player2.get<Character>();
+            const auto& p1State = player1.read<PlayerState>();
+            const auto& p2State = player2.read<PlayerState>();
+            const auto& p1Health = player1.read<Health>();
+            const auto& p2Health = player2.read<Health>();
+            const CharacterData& p1Char = *player1.read<Character>().data;
+            const CharacterData& p2Char = *player2.read<Character>().data;
 
             auto handleWinLose = [&](const bagel::Entity& loser, const bagel::Entity& winner) {
-                createWinText(winner.get<Character>());
+                createWinText(winner.read<Character>());
                 bool isJumping = loser.get<PlayerState>().isJumping;
                 loser.get<PlayerState>().reset();
                 loser.get<PlayerState>().state = State::GIDDY_FALL;
                 loser.get<PlayerState>().busy = true;
                 loser.get<PlayerState>().isJumping = isJumping;
-                loser.get<PlayerState>().busyFrames = loser.get<Character>().sprite[loser.get<PlayerState>().state].frameCount;
+                loser.get<PlayerState>().busyFrames = loser.read<Character>().data->sprite[loser.get<PlayerState>().state].frameCount;
                 loser.get<PlayerState>().freezeFrame = loser.get<PlayerState>().busyFrames - 1;
                 loser.get<PlayerState>().freezeFrameDuration = 1000;
 
@@ -627,7 +925,7 @@ namespace mortal_kombat
                 winner.get<PlayerState>().state = State::WIN;
                 winner.get<PlayerState>().busy = true;
                 winner.get<PlayerState>().isJumping = isJumping;
-                winner.get<PlayerState>().busyFrames = winner.get<Character>().sprite[winner.get<PlayerState>().state].frameCount;
+                winner.get<PlayerState>().busyFrames = winner.read<Character>().data->sprite[winner.get<PlayerState>().state].frameCount;
                 winner.get<PlayerState>().freezeFrame = winner.get<PlayerState>().busyFrames - 1;
                 winner.get<PlayerState>().freezeFrameDuration = 1000;
             };
@@ -638,9 +936,9 @@ namespace mortal_kombat
                 handleWinLose(player2, player1);
 
             // Direction update
-            bool isPlayer1Direction = player1.get<Position>().x < player2.get<Position>().x ? RIGHT : LEFT;
+            bool isPlayer1Direction = player1.read<Position>().x < player2.read<Position>().x ? RIGHT : LEFT;
             bool isPlayer2Direction = !isPlayer1Direction;
-            auto updateDirection = [](const bagel::Entity& player, bool newDir, const Character& character) {
+            auto updateDirection = [](const bagel::Entity& player, bool newDir, const CharacterData& character) {
                 auto& state = player.get<PlayerState>();
                 if (!state.isJumping && !state.busy && state.direction != newDir) {
                     state.direction = newDir;
@@ -656,59 +954,44 @@ namespace mortal_kombat
     }
 
 
-    void MK::InputSystem() {
-        static const bagel::Mask mask = bagel::MaskBuilder()
-            .set<Inputs>()
-            .build();
-
-        SDL_PumpEvents();
-        auto keyboardState = SDL_GetKeyboardState(nullptr);
-
-        if (keyboardState[SDL_SCANCODE_ESCAPE])
+    void MK::InputSystem(const KeyboardState& keyboardState) {
+        for (bagel::Entity entity : bagel::View<Inputs>())
         {
-            exit(0);
-        }
-
-        for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id)
-        {
-            if (bagel::Entity entity{e}; entity.test(mask))
-            {
-                auto& inputs = entity.get<Inputs>();
-                auto& playerState = entity.get<PlayerState>();
-
-                inputs++;
-
-                inputs[0] |= (playerState.direction == LEFT) ?
-                                                Inputs::DIRECTION_LEFT : Inputs::DIRECTION_RIGHT;
-                inputs[0] |= (playerState.isJumping) ?
-                                                Inputs::JUMPING : 0;
-
-                // Player 1 controls (using WASD for movement, space, etc. for actions)
-                if (playerState.playerNumber == 1) {
-                    inputs[0] |=
-                        (keyboardState[SDL_SCANCODE_H] ? Inputs::BLOCK : 0)
-                         | (keyboardState[SDL_SCANCODE_W] ? Inputs::UP : 0)
-                         | (keyboardState[SDL_SCANCODE_S] ? Inputs::DOWN : 0)
-                         | (keyboardState[SDL_SCANCODE_A] ? Inputs::LEFT : 0)
-                         | (keyboardState[SDL_SCANCODE_D] ? Inputs::RIGHT : 0)
-                         | (keyboardState[SDL_SCANCODE_F] ? Inputs::LOW_PUNCH : 0)
-                         | (keyboardState[SDL_SCANCODE_R] ? Inputs::HIGH_PUNCH : 0)
-                         | (keyboardState[SDL_SCANCODE_G] ? Inputs::LOW_KICK : 0)
-                         | (keyboardState[SDL_SCANCODE_T] ? Inputs::HIGH_KICK : 0);
-                }
-                // Player 2 controls (using arrow keys and numpad)
-                else if (playerState.playerNumber == 2) {
-                    inputs[0] |=
-                        (keyboardState[SDL_SCANCODE_APOSTROPHE] ? Inputs::BLOCK : 0)
-                         | (keyboardState[SDL_SCANCODE_UP] ? Inputs::UP : 0)
-                         | (keyboardState[SDL_SCANCODE_DOWN] ? Inputs::DOWN : 0)
-                         | (keyboardState[SDL_SCANCODE_LEFT] ? Inputs::LEFT : 0)
-                         | (keyboardState[SDL_SCANCODE_RIGHT] ? Inputs::RIGHT : 0)
-                         | (keyboardState[SDL_SCANCODE_K] ? Inputs::LOW_PUNCH : 0)
-                         | (keyboardState[SDL_SCANCODE_I] ? Inputs::HIGH_PUNCH : 0)
-                         | (keyboardState[SDL_SCANCODE_L] ? Inputs::LOW_KICK : 0)
-                         | (keyboardState[SDL_SCANCODE_O] ? Inputs::HIGH_KICK : 0);
-                }
+            auto& inputs = entity.get<Inputs>();
+            const auto& playerState = entity.read<PlayerState>();
+
+            inputs++;
+
+            inputs[0] |= (playerState.direction == LEFT) ?
+                                            Inputs::DIRECTION_LEFT : Inputs::DIRECTION_RIGHT;
+            inputs[0] |= (playerState.isJumping) ?
+                                            Inputs::JUMPING : 0;
+
+            // Player 1 controls (using WASD for movement, space, etc. for actions)
+            if (playerState.playerNumber == 1) {
+                inputs[0] |=
+                    (keyboardState[SDL_SCANCODE_H] ? Inputs::BLOCK : 0)
+                     | (keyboardState[SDL_SCANCODE_W] ? Inputs::UP : 0)
+                     | (keyboardState[SDL_SCANCODE_S] ? Inputs::DOWN : 0)
+                     | (keyboardState[SDL_SCANCODE_A] ? Inputs::LEFT : 0)
+                     | (keyboardState[SDL_SCANCODE_D] ? Inputs::RIGHT : 0)
+                     | (keyboardState[SDL_SCANCODE_F] ? Inputs::LOW_PUNCH : 0)
+                     | (keyboardState[SDL_SCANCODE_R] ? Inputs::HIGH_PUNCH : 0)
+                     | (keyboardState[SDL_SCANCODE_G] ? Inputs::LOW_KICK : 0)
+                     | (keyboardState[SDL_SCANCODE_T] ? Inputs::HIGH_KICK : 0);
+            }
+            // Player 2 controls (using arrow keys and numpad)
+            else if (playerState.playerNumber == 2) {
+                inputs[0] |=
+                    (keyboardState[SDL_SCANCODE_APOSTROPHE] ? Inputs::BLOCK : 0)
+                     | (keyboardState[SDL_SCANCODE_UP] ? Inputs::UP : 0)
+                     | (keyboardState[SDL_SCANCODE_DOWN] ? Inputs::DOWN : 0)
+                     | (keyboardState[SDL_SCANCODE_LEFT] ? Inputs::LEFT : 0)
+                     | (keyboardState[SDL_SCANCODE_RIGHT] ? Inputs::RIGHT : 0)
+                     | (keyboardState[SDL_SCANCODE_K] ? Inputs::LOW_PUNCH : 0)
+                     | (keyboardState[SDL_SCANCODE_I] ? Inputs::HIGH_PUNCH : 0)
+                     | (keyboardState[SDL_SCANCODE_L] ? Inputs::LOW_KICK : 0)
+                     | (keyboardState[SDL_SCANCODE_O] ? Inputs::HIGH_KICK : 0);
             }
         }
     }
@@ -716,14 +999,11 @@ namespace mortal_kombat
     void MK::CollisionSystem() const
     {
 
-        static const bagel::Mask maskAttack = bagel::MaskBuilder()
-            .set<Attack>()
-            .build();
-
         static const bagel::Mask maskPlayer = bagel::MaskBuilder()
             .set<PlayerState>()
             .build();
 
+        physicsTasks.reset();
         b2World_Step(boxWorld, BOX2D_STEP, 4);
 
         const auto se = b2World_GetSensorEvents(boxWorld);
@@ -731,14 +1011,15 @@ namespace mortal_kombat
         for (int i = 0; i < se.beginCount; ++i) {
             if (!b2Shape_IsValid(se.beginEvents[i].visitorShapeId)) continue;
             b2BodyId b = b2Shape_GetBody(se.beginEvents[i].visitorShapeId);
-            const auto* e_b = static_cast<bagel::ent_type*>(b2Body_GetUserData(b));
+            const void* e_b = b2Body_GetUserData(b);
             if (!b2Shape_IsValid(se.beginEvents[i].sensorShapeId)) continue;
             b2BodyId s = b2Shape_GetBody(se.beginEvents[i].sensorShapeId);
-            const auto* e_s = static_cast<bagel::ent_type*>(b2Body_GetUserData(s));
+            const void* e_s = b2Body_GetUserData(s);
             if (!e_b || !e_s) continue;
 
-            bagel::Entity eBody = bagel::Entity{(*e_s)};
-            bagel::Entity eSensor = bagel::Entity{(*e_b)};
+            bagel::Entity eBody = bagel::Entity{bagel::ent_type::fromUserData(e_s)};
+            bagel::Entity eSensor = bagel::Entity{bagel::ent_type::fromUserData(e_b)};
+            if (!eBody.alive() || !eSensor.alive()) continue;
 
             if (eBody.test(maskPlayer) && eSensor.test(maskPlayer))
                 eBody.get<Collider>().isPlayerSensor = true;
@@ -750,24 +1031,21 @@ namespace mortal_kombat
                 if (eSensor.get<Boundary>().side == RIGHT)
                     eBody.get<Collider>().isRightBoundarySensor = true;
             }
-
-            if (eSensor.test(maskAttack) && eBody.test(maskPlayer)
-                && eSensor.get<Attack>().attacker != eBody.get<PlayerState>().playerNumber)
-                CombatSystem(eSensor, eBody);
         }
 
         // Handle end events
         for (int i = 0; i < se.endCount; ++i) {
             if (!b2Shape_IsValid(se.endEvents[i].visitorShapeId)) continue;
             b2BodyId b = b2Shape_GetBody(se.endEvents[i].visitorShapeId);
-            const auto* e_b = static_cast<bagel::ent_type*>(b2Body_GetUserData(b));
+            const void* e_b = b2Body_GetUserData(b);
             if (!b2Shape_IsValid(se.endEvents[i].sensorShapeId)) continue;
             b2BodyId s = b2Shape_GetBody(se.endEvents[i].sensorShapeId);
-            const auto* e_s = static_cast<bagel::ent_type*>(b2Body_GetUserData(s));
+            const void* e_s = b2Body_GetUserData(s);
             if (!e_b || !e_s) continue;
 
-            bagel::Entity eBody = bagel::Entity{(*e_s)};
-            bagel::Entity eSensor = bagel::Entity{(*e_b)};
+            bagel::Entity eBody = bagel::Entity{bagel::ent_type::fromUserData(e_s)};
+            bagel::Entity eSensor = bagel::Entity{bagel::ent_type::fromUserData(e_b)};
+            if (!eBody.alive() || !eSensor.alive()) continue;
 
             if (eBody.test(maskPlayer) && eSensor.test(maskPlayer))
                 eBody.get<Collider>().isPlayerSensor = false;
@@ -783,38 +1061,30 @@ namespace mortal_kombat
     }
 
     void MK::ClockSystem() {
-        static const bagel::Mask mask = bagel::MaskBuilder()
-            .set<Time>()
-            .build();
-
-        for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id)
+        for (bagel::Entity entity : bagel::View<Time>())
         {
-            if (bagel::Entity entity{e}; entity.test(mask))
-            {
-                --entity.get<Time>().time;
-            }
+            --entity.get<Time>().time;
         }
     }
 
-    void MK::CombatSystem(bagel::Entity &eAttack, bagel::Entity &ePlayer) {
-        auto& attack = eAttack.get<Attack>();
+    bool MK::CombatSystem(const State attack, bagel::Entity &ePlayer) {
         auto& playerState = ePlayer.get<PlayerState>();
         auto& health = ePlayer.get<Health>();
-        auto& character = ePlayer.get<Character>();
+        const CharacterData& character = *ePlayer.read<Character>().data;
 
         // Blocking and evading attacks
         if (playerState.state == State::CROUCH_BLOCK || playerState.state == State::GETUP
             || playerState.isLaying || (playerState.state == State::BLOCK
-                && attack.type != State::LOW_SWEEP_KICK && attack.type != State::CROUCH_KICK))
+                && attack != State::LOW_SWEEP_KICK && attack != State::CROUCH_KICK))
         {
             health.health -= 1;
             --(playerState.currFrame);
-            return;
+            return false;
         }
 
         bool isJumping = playerState.isJumping;
         bool isCrouching = playerState.isCrouching;
-        switch (attack.type)
+        switch (attack)
         {
             case State::LOW_PUNCH:
                 health.health -= 5;
@@ -1002,117 +1272,108 @@ namespace mortal_kombat
                 }
                 playerState.busyFrames = character.sprite[playerState.state].frameCount;
                 playerState.busy = true;
-                if (eAttack.has<SpecialAttack>())
-                {
-                    eAttack.get<SpecialAttack>().explode = true;
-                }
                 break;
             default:
                 break;
         }
+        return true;
     }
 
-    void MK::AttackDecaySystem() {
-        static const bagel::Mask mask = bagel::MaskBuilder()
-            .set<Collider>()
-            .set<Attack>()
-            .set<Time>()
-            .build();
+    void MK::HitSystem() const
+    {
+        hits.clear();
 
-        for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-            if (bagel::Entity entity{e}; entity.test(mask)) {
-                auto& collider = entity.get<Collider>();
-                auto& time = entity.get<Time>();
+        const bagel::View<PlayerState, Position, Character> fighters;
+        for (bagel::Entity attacker : fighters)
+        {
+            const auto& state = attacker.read<PlayerState>();
+            if (!state.busy || !state.isAttacking || state.isSpecialAttack)
+                continue;
 
-                if (time.time <= 0) {
-                    if (b2Body_IsValid(collider.body)) {
-                        const auto* e_p = static_cast<bagel::ent_type*>(b2Body_GetUserData(collider.body));
-                        b2DestroyBody(collider.body);
-                        delete e_p;
-                    }
-                    collider.body = b2_nullBodyId;
-                    bagel::World::destroyEntity(e);
-                }
+            const HitBox& hitBox = attacker.read<Character>().data->frameBoxes(state.state, state.currFrame).hit;
+            if (hitBox.empty())
+                continue;
+            const auto& position = attacker.read<Position>();
+            const HitBox strike = hitBox.placed(position.x, position.y, state.direction == LEFT);
+
+            for (bagel::Entity victim : fighters)
+            {
+                const auto& victimState = victim.read<PlayerState>();
+                if (victimState.playerNumber == state.playerNumber)
+                    continue;
+
+                const auto& victimPosition = victim.read<Position>();
+                const HitBox hurt = hurtBox(victimState.isCrouching)
+                    .placed(victimPosition.x, victimPosition.y, victimState.direction == LEFT);
+                if (strike.overlaps(hurt))
+                    hits.push_back({victim.entity(), state.state});
             }
         }
+
+        for (const Hit& hit : hits)
+        {
+            bagel::Entity victim{hit.victim};
+            CombatSystem(hit.attack, victim);
+        }
     }
 
-    void MK::SpecialAttackSystem() {
-        static const bagel::Mask mask = bagel::MaskBuilder()
-            .set<SpecialAttack>()
-            .set<Character>()
-            .build();
+    void MK::ProjectileSystem() const
+    {
+        Projectiles::HurtBoxes hurt{};
+        std::array<bagel::ent_type, 3> fighters{};
+        for (bagel::Entity fighter : bagel::View<PlayerState, Position, Character>())
+        {
+            const auto& state = fighter.read<PlayerState>();
+            const auto& position = fighter.read<Position>();
+            hurt[state.playerNumber] = hurtBox(state.isCrouching).placed(position.x, position.y, state.direction == LEFT);
+            fighters[state.playerNumber] = fighter.entity();
+        }
 
-        for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-            if (bagel::Entity entity{e}; entity.test(mask))
-            {
-                if (entity.get<SpecialAttack>().explode)
-                {
-                    auto& spritePrev = entity.get<Character>().specialAttackSprite[entity.get<SpecialAttack>().type];
-                    auto& spriteNext = entity.get<Character>().specialAttackSprite[SpecialAttacks::EXPLOSION];
-                    entity.get<Movement>().reset();
-                    entity.get<Position>().y -= ((spriteNext.h - spritePrev.h) / 2.0f) * SCALE_CHARACTER;
-                    if (entity.get<SpecialAttack>().direction == LEFT)
-                        entity.get<Position>().x += 0;
-                    if (entity.get<SpecialAttack>().direction == RIGHT)
-                        entity.get<Position>().x += ((spriteNext.w) / 2.0f) * SCALE_CHARACTER;
-                    entity.get<SpecialAttack>().type = SpecialAttacks::EXPLOSION;
-                    entity.get<SpecialAttack>().frame = 0;
-                    entity.get<SpecialAttack>().totalFrames = spriteNext.frameCount - 1;
-                    entity.get<SpecialAttack>().explode = false;
-                    entity.get<Time>().time = 4;
-                }
-            }
+        if (projectiles.update(hurt))
+        {
+            // Fireballs are the only projectile that hurts; explosions are spent
+            projectiles.resolveHits([&](const int player) {
+                bagel::Entity victim{fighters[player]};
+                return CombatSystem(State::SPECIAL_1, victim);
+            });
         }
+        projectiles.compact();
     }
 
     void MK::HealthBarSystem() {
-        static const bagel::Mask mask = bagel::MaskBuilder()
-            .set<HealthBarReference>()
-            .set<DamageVisual>()
-            .set<Texture>()
-            .set<Position>()
-            .build();
-
-        for (bagel::ent_type e = {0}; e.id <= bagel::World::maxId().id; ++e.id) {
-            if (bagel::Entity entity{e}; entity.test(mask)) {
+        for (bagel::Entity entity : bagel::View<HealthBarReference, DamageVisual, Texture, Position>())
+        {
 
-                // Use HealthBarReference to access actual player health
-                auto& reference = entity.get<HealthBarReference>();
-                if (reference.target.id == -1) continue;
+            // Use HealthBarReference to access actual player health
+            auto& reference = entity.get<HealthBarReference>();
+            if (!bagel::World::alive(reference.target)) continue;
 
-                bagel::Entity player = bagel::Entity{reference.target};
-                auto& health = player.get<Health>();
+            bagel::Entity player = bagel::Entity{reference.target};
+            const auto& health = player.read<Health>();
+            auto& damage = entity.get<DamageVisual>();
 
-                // Continue as usual
-                auto& damage = entity.get<DamageVisual>();
-                auto& texture = entity.get<Texture>();
+            // Nothing to do unless the player was hit since the last frame or the trail is still catching up
+            if (!player.changedSince<Health>(bagel::World::tick() - 1) && damage.trailingHealth <= health.health)
+                continue;
 
-                float ratio = std::max(0.0f, health.health / health.max_health);
+            auto& texture = entity.get<Texture>();
 
-                // Smooth trailing damage effect
-                if (damage.trailingHealth > health.health) {
-                    constexpr float TRAIL_SPEED = 0.5f;
-                    damage.trailingHealth -= TRAIL_SPEED;
-                    if (damage.trailingHealth < health.health)
-                        damage.trailingHealth = health.health;
-                }
+            float ratio = std::max(0.0f, health.health / health.max_health);
 
-                texture.rect.w = 250.0f * ratio;
+            // Smooth trailing damage effect
+            if (damage.trailingHealth > health.health) {
+                constexpr float TRAIL_SPEED = 0.5f;
+                damage.trailingHealth -= TRAIL_SPEED;
+                if (damage.trailingHealth < health.health)
+                    damage.trailingHealth = health.health;
             }
+
+            texture.rect.w = 250.0f * ratio;
         }
     }
 
-    SDL_Texture* MK::TextureSystem::getTexture(SDL_Renderer* renderer, const std::string& filePath, IgnoreColorKey ignoreColorKey)
+    SDL_Surface* MK::TextureSystem::decode(const std::string& filePath, IgnoreColorKey ignoreColorKey)
     {
-        // Check if the texture is already cached
-        std::string cacheKey = filePath + "_" + std::to_string(static_cast<int>(ignoreColorKey));
-
-        if (textureCache.find(cacheKey) != textureCache.end()) {
-            return textureCache[cacheKey];
-        }
-
-        // Load the texture if not cached
         SDL_Surface* surface = IMG_Load(filePath.c_str());
         if (!surface) {
             SDL_Log("Failed to load image: %s, SDL_Error: %s", filePath.c_str(), SDL_GetError());
@@ -1134,45 +1395,267 @@ namespace mortal_kombat
                                                       BACKGROUND_COLOR_IGNORE_GREEN,
                                                       BACKGROUND_COLOR_IGNORE_BLUE));
                 break;
-        case IgnoreColorKey::NAME_BAR:
-                SDL_SetSurfaceColorKey(surface, true, SDL_MapRGB(fmt, nullptr,
-                                                      COLOR_KEY_NAME_BAR_RED,
-                                                      COLOR_KEY_NAME_BAR_GREEN,
-                                                      COLOR_KEY_NAME_BAR_BLUE));
-                break;
-        case IgnoreColorKey::DAMAGE_BAR:
-                SDL_SetSurfaceColorKey(surface, true, SDL_MapRGB(fmt, nullptr,
-                                                      COLOR_KEY_DAMAGE_BAR_RED,
-                                                      COLOR_KEY_DAMAGE_BAR_GREEN,
-                                                      COLOR_KEY_DAMAGE_BAR_BLUE));
+            case IgnoreColorKey::MENUS:
+            {
+                // A single surface key can't cover several colors, so bake them into alpha
+                SDL_Surface* rgba = SDL_ConvertSurface(surface, SDL_PIXELFORMAT_RGBA32);
+                SDL_DestroySurface(surface);
+                if (!rgba) {
+                    SDL_Log("Failed to convert image: %s, SDL_Error: %s", filePath.c_str(), SDL_GetError());
+                    return nullptr;
+                }
+                surface = rgba;
+                for (const KeyedRegion& region : MENUS_REGIONS) {
+                    bakeColorKey(surface, region);
+                }
                 break;
-        case IgnoreColorKey::WIN_TEXT:
-                SDL_SetSurfaceColorKey(surface, true, SDL_MapRGB(fmt, nullptr,
-                                                      WIN_TEXT_COLOR_IGNORE_RED,
-                                                      WIN_TEXT_COLOR_IGNORE_GREEN,
-                                                      WIN_TEXT_COLOR_IGNORE_BLUE));
+            }
         }
+        return surface;
+    }
 
+    void MK::TextureSystem::bakeColorKey(SDL_Surface* surface, const KeyedRegion& region)
+    {
+        const int right = std::min(surface->w, region.rect.x + region.rect.w);
+        const int bottom = std::min(surface->h, region.rect.y + region.rect.h);
+
+        for (int y = std::max(0, region.rect.y); y < bottom; ++y) {
+            Uint8* row = static_cast<Uint8*>(surface->pixels) + y * surface->pitch;
+            for (int x = std::max(0, region.rect.x); x < right; ++x) {
+                Uint8* pixel = row + x * 4;
+                if (pixel[0] == region.red && pixel[1] == region.green && pixel[2] == region.blue) {
+                    pixel[3] = 0;
+                }
+            }
+        }
+    }
+
+    SDL_Texture* MK::TextureSystem::upload(SDL_Renderer* renderer, SDL_Surface* surface, const std::string& filePath)
+    {
         SDL_Texture* texture = SDL_CreateTextureFromSurface(renderer, surface);
         SDL_DestroySurface(surface);
 
         if (!texture) {
             SDL_Log("Failed to create texture: %s, SDL_Error: %s", filePath.c_str(), SDL_GetError());
+        }
+        return texture;
+    }
+
+    SDL_Surface* MK::TextureSystem::decodeAtlas(const std::string& name, SpriteAtlas& atlas)
+    {
+        if (!atlas.loadTable("res/" + name + ".atlas")) {
             return nullptr;
         }
 
-        // Cache the texture
-        textureCache[cacheKey] = texture;
-        return texture;
+        const std::string imagePath = "res/" + name + ".atlas.png";
+        SDL_Surface* surface = IMG_Load(imagePath.c_str());
+        if (!surface) {
+            SDL_Log("Failed to load atlas: %s, SDL_Error: %s", imagePath.c_str(), SDL_GetError());
+            return nullptr;
+        }
+
+        SDL_Palette* palette = SDL_GetSurfacePalette(surface);
+        if (surface->format == SDL_PIXELFORMAT_INDEX8 && palette) {
+            // The PNG may not carry transparency for its palette; the cook reserves this entry for it
+            SDL_Color transparent = palette->colors[ATLAS_TRANSPARENT_INDEX];
+            transparent.a = SDL_ALPHA_TRANSPARENT;
+            SDL_SetPaletteColors(palette, &transparent, ATLAS_TRANSPARENT_INDEX, 1);
+            atlas.buildPalettes(palette);
+        }
+        return surface;
+    }
+
+    int MK::TextureSystem::loadAsync(bagel::ThreadPool& pool, const std::string& filePath, IgnoreColorKey ignoreColorKey)
+    {
+        // Entities sharing a sheet share its handle
+        for (size_t i = 0; i < registry.size(); ++i) {
+            if (!registry[i].character && registry[i].name == filePath && registry[i].ignoreColorKey == ignoreColorKey) {
+                return static_cast<int>(i);
+            }
+        }
+
+        Entry& entry = registry.emplace_back();
+        entry.name = filePath;
+        entry.ignoreColorKey = ignoreColorKey;
+
+        loadPool = &pool;
+        pool.submit({[](void* arg) {
+            Entry& e = *static_cast<Entry*>(arg);
+            e.surface = decode(e.name, e.ignoreColorKey);
+            e.decoded.store(true, std::memory_order_release);
+        }, &entry});
+        return static_cast<int>(registry.size()) - 1;
+    }
+
+    int MK::TextureSystem::loadCharacterAsync(bagel::ThreadPool& pool, const std::string& name)
+    {
+        for (size_t i = 0; i < registry.size(); ++i) {
+            if (registry[i].character && registry[i].name == name) {
+                return static_cast<int>(i);
+            }
+        }
+
+        Entry& entry = registry.emplace_back();
+        entry.name = name;
+        entry.character = true;
+
+        loadPool = &pool;
+        pool.submit({[](void* arg) {
+            Entry& e = *static_cast<Entry*>(arg);
+            e.surface = decodeAtlas(e.name, e.atlas);
+            e.cooked = e.surface != nullptr;
+            if (!e.cooked) {
+                e.surface = decode("res/" + e.name + ".png", IgnoreColorKey::CHARACTER);
+            }
+            e.decoded.store(true, std::memory_order_release);
+        }, &entry});
+        return static_cast<int>(registry.size()) - 1;
+    }
+
+    void MK::TextureSystem::uploadLoaded(SDL_Renderer* renderer)
+    {
+        // Without workers nobody else drains the queue; decode one per frame here
+        if (loadPool && loadPool->workers() == 0) {
+            loadPool->runOne();
+        }
+
+        for (size_t handle = 0; handle < registry.size(); ++handle)
+        {
+            Entry& entry = registry[handle];
+            if (entry.uploaded || !entry.decoded.load(std::memory_order_acquire)) {
+                continue;
+            }
+            entry.uploaded = true;
+
+            SDL_Texture* texture = entry.surface ? upload(renderer, entry.surface, entry.name) : nullptr;
+            if (entry.cooked) {
+                // Renderers without indexed textures expand the atlas to RGBA; it then draws
+                // with its own colors only. The palettes stay, the simulation may hold them
+                if (texture && texture->format != SDL_PIXELFORMAT_INDEX8 && entry.atlas.palette(PaletteSwap::NONE)) {
+                    SDL_Log("Renderer has no indexed textures, palette swaps disabled for %s", entry.name.c_str());
+                }
+                entry.atlas.tex = texture;
+                entry.texture = Texture{texture, {}, {}, &entry.atlas,
+                                        entry.atlas.palette(PaletteSwap::NONE), static_cast<int>(handle)};
+            } else {
+                entry.texture = Texture{texture, {}, {}, nullptr, nullptr, static_cast<int>(handle)};
+            }
+        }
+    }
+
+    void MK::TextureSystem::waitForDecodes()
+    {
+        for (const Entry& entry : registry) {
+            while (!entry.decoded.load(std::memory_order_acquire)) {
+                if (!loadPool->runOne()) {
+                    std::this_thread::yield();
+                }
+            }
+        }
+    }
+
+    void MK::TextureSystem::finishLoading(SDL_Renderer* renderer)
+    {
+        waitForDecodes();
+        uploadLoaded(renderer);
+    }
+
+    void MK::TextureSystem::clearCache()
+    {
+        // Decodes still in flight write into the registry; let them land before dropping it
+        waitForDecodes();
+        for (Entry& entry : registry) {
+            if (entry.uploaded) {
+                SDL_DestroyTexture(entry.texture.tex);
+            } else {
+                SDL_DestroySurface(entry.surface);
+            }
+            entry.atlas.releasePalettes();
+        }
+        registry.clear();
+        loadPool = nullptr;
+    }
+
+    bool MK::SpriteAtlas::loadTable(const std::string& path)
+    {
+        std::ifstream table(path);
+        std::string header;
+        if (!std::getline(table, header) || header != ATLAS_TABLE_HEADER) {
+            return false;
+        }
+
+        char group;
+        int index, frame;
+        AtlasFrame f;
+        while (table >> group >> index >> frame >> f.x >> f.y >> f.w >> f.h
+                     >> f.offsetX >> f.offsetY >> f.cellW >> f.cellH)
+        {
+            std::vector<AtlasFrame>* frames = nullptr;
+            if (group == ATLAS_STATE_GROUP && index >= 0 && index < CHARACTER_SPRITE_SIZE) {
+                frames = &states[index];
+            } else if (group == ATLAS_SPECIAL_GROUP && index >= 0 && index < SPECIAL_ATTACK_SPRITE_SIZE) {
+                frames = &specials[index];
+            }
+            if (!frames || frame < 0) {
+                SDL_Log("Malformed atlas table: %s", path.c_str());
+                return false;
+            }
+
+            if (frames->size() <= static_cast<size_t>(frame)) {
+                frames->resize(frame + 1);
+            }
+            (*frames)[frame] = f;
+        }
+        return table.eof();
+    }
+
+    void MK::SpriteAtlas::buildPalettes(const SDL_Palette* base)
+    {
+        releasePalettes();
+        for (int swap = 0; swap < static_cast<int>(PaletteSwap::COUNT); ++swap)
+        {
+            SDL_Color colors[ATLAS_PALETTE_SIZE];
+            const int count = std::min(base->ncolors, ATLAS_PALETTE_SIZE);
+            for (int i = 0; i < count; ++i)
+            {
+                SDL_Color c = base->colors[i];
+                // The costume is the only part of the art where blue dominates
+                if (c.b > c.r && c.b > c.g)
+                {
+                    if (static_cast<PaletteSwap>(swap) == PaletteSwap::YELLOW)
+                        std::swap(c.r, c.b);
+                    else if (static_cast<PaletteSwap>(swap) == PaletteSwap::GREEN)
+                        std::swap(c.g, c.b);
+                }
+                colors[i] = c;
+            }
+
+            palettes[swap] = SDL_CreatePalette(count);
+            if (!palettes[swap] || !SDL_SetPaletteColors(palettes[swap], colors, 0, count))
+            {
+                SDL_Log("Failed to create palette: %s", SDL_GetError());
+                releasePalettes();
+                return;
+            }
+        }
+    }
+
+    void MK::SpriteAtlas::releasePalettes()
+    {
+        for (SDL_Palette*& palette : palettes)
+        {
+            if (palette)
+                SDL_DestroyPalette(palette);
+            palette = nullptr;
+        }
     }
 
     // ------------------------------- Entities -------------------------------
 
     bagel::ent_type MK::createPlayer(float x, float y, Character character, int playerNumber) const
     {
-        // Construct the texture path
-        std::string texturePath = "res/" + std::string(character.name) + ".png";
-        auto texture = TextureSystem::getTexture(ren, texturePath, TextureSystem::IgnoreColorKey::CHARACTER);
+        character.texture = TextureSystem::loadCharacterAsync(pool, character.data->name);
+        projectiles.setShooter(playerNumber, character);
 
         b2BodyDef bodyDef = b2DefaultBodyDef();
         bodyDef.type = b2_kinematicBody;
@@ -1197,136 +1680,182 @@ namespace mortal_kombat
         entity.addAll(Position{x, y},
                       Movement{0, 0},
                       Collider{body, shape},
-                      Texture{texture},
+                      Texture{},
+                      PendingTexture{character.texture, character.palette},
+                      RenderLayer{Layer::FIGHTERS, static_cast<Uint16>(playerNumber)},
                       playerState,
                       Inputs{},
                       character,
                       Health{100, 100});
 
-        b2Body_SetUserData(body, new bagel::ent_type{entity.entity()});
+        b2Body_SetUserData(body, entity.entity().toUserData());
         return entity.entity();
     }
 
-        void MK::createAttack(float x, float y, State type, int playerNumber, bool direction) const
+        MK::Projectiles::Projectiles()
+        {
+            for (auto* array : {&x, &y, &vx, &boxX, &boxY, &boxW, &boxH})
+                array->reserve(MAX_PROJECTILES);
+            for (auto* array : {&frame, &lastFrame, &shooterOf, &direction, &targets, &hits})
+                array->reserve(MAX_PROJECTILES);
+            life.reserve(MAX_PROJECTILES);
+            type.reserve(MAX_PROJECTILES);
+        }
+
+        void MK::Projectiles::setShooter(const int playerNumber, const Character& character)
         {
+            shooters[playerNumber] = {character.data, character.texture, character.palette};
+        }
 
-            float width = 0.0f;
-            float height = 0.0f;
-            float xOffset = 0.0f;
-            float yOffset = 0.0f;
+        void MK::Projectiles::spawn(const float x0, const float y0, const SpecialAttacks attack, const int playerNumber,
+                                    const bool facing)
+        {
+            if (attack != SpecialAttacks::FIREBALL || x.size() == MAX_PROJECTILES)
+                return;
+
+            const Shooter& shooter = shooters[playerNumber];
+            const SpriteInfo& sprite = shooter.data->specialAttackSprite[attack];
+            x.push_back(x0 + (CHAR_SQUARE_WIDTH / 2.0f) * SCALE_CHARACTER);
+            y.push_back(y0 + (shooter.data->specialAttackOffset_y - sprite.h / 2.0f) * SCALE_CHARACTER);
+            vx.push_back(facing == LEFT ? -SPEED : SPEED);
+            // Same box the Box2D sensor used: unscaled, centered at (x - w, y - offset_y + h/2) with
+            // its axes swapped, so it is h wide and w tall
+            boxX.push_back(-sprite.w - sprite.h / 2.0f);
+            boxY.push_back(-shooter.data->specialAttackOffset_y + (sprite.h - sprite.w) / 2.0f);
+            boxW.push_back(sprite.h);
+            boxH.push_back(sprite.w);
+            life.push_back(LIFE_TIME);
+            frame.push_back(0);
+            lastFrame.push_back(static_cast<Uint8>(sprite.frameCount - 1));
+            type.push_back(attack);
+            shooterOf.push_back(static_cast<Uint8>(playerNumber));
+            direction.push_back(facing);
+            targets.push_back(static_cast<Uint8>((1 << 1 | 1 << 2) & ~(1 << playerNumber)));
+            hits.push_back(0);
+        }
 
-            switch (type)
+        bool MK::Projectiles::update(const HurtBoxes& hurt)
+        {
+            // Plain loops over raw pointers: a store through a Uint8 may alias anything, so indexing
+            // the vectors directly would reload their data pointers every iteration and stop the
+            // vectorizer. A fighter that is missing has an empty hurt box and can't be hit
+            const size_t n = x.size();
+            float* const px = x.data();
+            const float* const pvx = vx.data();
+            const float* const py = y.data();
+            const float* const pbx = boxX.data();
+            const float* const pby = boxY.data();
+            const float* const pbw = boxW.data();
+            const float* const pbh = boxH.data();
+            int* const plife = life.data();
+            Uint8* const pframe = frame.data();
+            const Uint8* const plast = lastFrame.data();
+            const Uint8* const ptargets = targets.data();
+            Uint8* const phits = hits.data();
+
+            for (size_t i = 0; i < n; ++i)
             {
-                case State::FORWARD_JUMP_PUNCH:
-                case State::JUMP_PUNCH:
-                case State::JUMP_LOW_KICK:
-                case State::JUMP_HIGH_KICK:
-                case State::LOW_PUNCH:
-                case State::HIGH_PUNCH:
-                    width = 70.0f;
-                    height = 40.0f;
-                    xOffset = width / 2.0f * (direction == LEFT ? -1.0f : 1.0f);
-                    yOffset = 40.0f;
-                    break;
-                case State::LOW_KICK:
-                case State::HIGH_KICK:
-                    width = 95.0f;
-                    height = 40.0f;
-                    xOffset = width / 2.0f * (direction == LEFT ? -1.0f : 1.0f);
-                    yOffset = 0.0f;
-                    break;
-                case State::HIGH_SWEEP_KICK:
-                    width = 95.0f;
-                    height = 40.0f;
-                    xOffset = width / 2.0f * (direction == LEFT ? -1.0f : 1.0f);
-                    yOffset = 40.0f;
-                    break;
-                case State::CROUCH_KICK:
-                case State::LOW_SWEEP_KICK:
-                    width = 85.0f;
-                    height = 40.0f;
-                    xOffset = width / 2.0f * (direction == LEFT ? -1.0f : 1.0f);
-                    yOffset = -40.0f;
-                    break;
-                case State::UPPERCUT:
-                    width = 50.0f;
-                    height = 40.0f;
-                    xOffset = width / 2.0f * (direction == LEFT ? -1.0f : 1.0f);
-                    yOffset = 40.0f;
-                    break;
-                default: // Type is not a valid attack
-                    return;
+                px[i] += pvx[i];
+                --plife[i];
+                pframe[i] += pframe[i] < plast[i];
             }
 
-            b2BodyDef bodyDef = b2DefaultBodyDef();
-            bodyDef.type = b2_kinematicBody;
-            bodyDef.position= getPosition(x + xOffset, y + yOffset);
-
-            b2ShapeDef shapeDef = b2DefaultShapeDef();
-            shapeDef.enableSensorEvents = true;
-            shapeDef.isSensor = true;
-
-            b2Polygon boxShape = b2MakeBox((width / 2.0f) / WINDOW_SCALE,
-                                           (height / 2.0f) / WINDOW_SCALE);
-
-            b2BodyId body = b2CreateBody(boxWorld, &bodyDef);
-            b2ShapeId shape = b2CreatePolygonShape(body, &shapeDef, &boxShape);
-
-            bagel::Entity entity = bagel::Entity::create();
-            entity.addAll(Position{x, y},
-                          Collider{body, shape},
-                          Attack{type, playerNumber},
-                          Time{Attack::ATTACK_LIFE_TIME});
-
-            b2Body_SetUserData(body, new bagel::ent_type{entity.entity()});
+            const int present = !hurt[1].empty() << 1 | !hurt[2].empty() << 2;
+            Uint8 any = 0;
+            for (size_t i = 0; i < n; ++i)
+            {
+                const HitBox box{px[i] + pbx[i], py[i] + pby[i], pbw[i], pbh[i]};
+                const int touched = box.overlaps(hurt[1]) << 1 | box.overlaps(hurt[2]) << 2;
+                phits[i] = static_cast<Uint8>(touched & present & ptargets[i]);
+                any |= phits[i];
+            }
+            return any != 0;
         }
 
-
-        void MK::createSpecialAttack(float x, float y, SpecialAttacks type, int playerNumber,
-                                    bool direction, Character& character) const
+        void MK::Projectiles::explode(const size_t i)
         {
-            // Construct the texture path
-            std::string texturePath = "res/" + std::string(character.name) + ".png";
-            auto texture = TextureSystem::getTexture(ren, texturePath, TextureSystem::IgnoreColorKey::CHARACTER);
-
-            b2BodyDef bodyDef = b2DefaultBodyDef();
-            bodyDef.type = b2_kinematicBody;
-            bodyDef.position= getPosition(x, y + CHARACTER_HEIGHT / 2.0f);
-
-            b2ShapeDef shapeDef = b2DefaultShapeDef();
-            shapeDef.enableSensorEvents = true;
-            shapeDef.isSensor = true;
+            const CharacterData& shooter = *shooters[shooterOf[i]].data;
+            const SpriteInfo& prev = shooter.specialAttackSprite[type[i]];
+            const SpriteInfo& next = shooter.specialAttackSprite[SpecialAttacks::EXPLOSION];
+
+            vx[i] = 0;
+            y[i] -= ((next.h - prev.h) / 2.0f) * SCALE_CHARACTER;
+            if (direction[i] == RIGHT)
+                x[i] += (next.w / 2.0f) * SCALE_CHARACTER;
+            type[i] = SpecialAttacks::EXPLOSION;
+            frame[i] = 0;
+            lastFrame[i] = 0;
+            life[i] = EXPLOSION_TIME;
+            targets[i] = 0;
+        }
 
-            b2Polygon boxShape = b2MakeBox((character.specialAttackSprite[type].h / 2.0f) / WINDOW_SCALE,
-                                         (character.specialAttackSprite[type].w / 2.0f) / WINDOW_SCALE);
+        void MK::Projectiles::compact()
+        {
+            size_t kept = 0;
+            for (size_t i = 0; i < x.size(); ++i)
+            {
+                if (life[i] < 0)
+                    continue;
+                if (kept != i)
+                {
+                    x[kept] = x[i]; y[kept] = y[i]; vx[kept] = vx[i];
+                    boxX[kept] = boxX[i]; boxY[kept] = boxY[i]; boxW[kept] = boxW[i]; boxH[kept] = boxH[i];
+                    life[kept] = life[i];
+                    frame[kept] = frame[i]; lastFrame[kept] = lastFrame[i];
+                    type[kept] = type[i];
+                    shooterOf[kept] = shooterOf[i]; direction[kept] = direction[i];
+                    targets[kept] = targets[i];
+                }
+                ++kept;
+            }
+            if (kept == x.size())
+                return;
+            for (auto* array : {&x, &y, &vx, &boxX, &boxY, &boxW, &boxH})
+                array->resize(kept);
+            for (auto* array : {&frame, &lastFrame, &shooterOf, &direction, &targets, &hits})
+                array->resize(kept);
+            life.resize(kept);
+            type.resize(kept);
+        }
 
-            b2BodyId body = b2CreateBody(boxWorld, &bodyDef);
-            b2ShapeId shape = b2CreatePolygonShape(body, &shapeDef, &boxShape);
+        void MK::PhysicsTasks::install(b2WorldDef& def)
+        {
+            // Without workers every range would run on the stepping thread anyway, and
+            // Box2D's own serial path does that without the queueing
+            if (pool.workers() == 0 || pool.workers() + 1 > MAX_WORKERS)
+                return;
+            def.workerCount = pool.workers() + 1;
+            def.enqueueTask = enqueue;
+            def.finishTask = finish;
+            def.userTaskContext = this;
+        }
 
-            State state;
-            switch (type)
+        void* MK::PhysicsTasks::enqueue(b2TaskCallback* callback, const int itemCount, const int minRange,
+                                        void* taskContext, void* userContext)
+        {
+            auto& self = *static_cast<PhysicsTasks*>(userContext);
+            // Even a single item goes to the pool: the solver enqueues one task per worker with
+            // one item each, and they only run in parallel if they leave this thread. Out of
+            // slots, running it here is what Box2D expects on nullptr
+            if (self.used == MAX_TASKS)
             {
-                case SpecialAttacks::FIREBALL:
-                    state = State::SPECIAL_1;
-                    break;
-                    // add more special attacks here
-                default:
-                    return; // Invalid special attack type
+                callback(0, itemCount, self.pool.workerIndex(), taskContext);
+                return nullptr;
             }
 
-            // Add components to the entity
-            bagel::Entity entity = bagel::Entity::create();
-            entity.addAll(Position{x + ((CHAR_SQUARE_WIDTH / 2.0f) * SCALE_CHARACTER),
-                                    y + ((character.specialAttackOffset_y - (character.specialAttackSprite[type].h / 2.0f)) * SCALE_CHARACTER)},
-                       Movement{(direction == LEFT) ? -15.0f : 15.0f, 0},
-                       Collider{body, shape},
-                       Texture{texture},
-                       Attack{state, playerNumber},
-                       SpecialAttack{type, direction},
-                       character,
-                       Time{SpecialAttack::SPECIAL_ATTACK_LIFE_TIME});
-
-            b2Body_SetUserData(body, new bagel::ent_type{entity.entity()});
+            Task& task = self.tasks[self.used++];
+            task.callback = callback;
+            task.context = taskContext;
+            task.loop.start(self.pool, [](const int begin, const int end, const int worker, void* context) {
+                const auto& t = *static_cast<Task*>(context);
+                t.callback(begin, end, static_cast<uint32_t>(worker), t.context);
+            }, &task, itemCount, minRange);
+            return &task;
+        }
+
+        void MK::PhysicsTasks::finish(void* userTask, void*)
+        {
+            static_cast<Task*>(userTask)->loop.wait();
         }
 
         void MK::createBoundary(bool side) const
@@ -1357,23 +1886,26 @@ namespace mortal_kombat
             entity.addAll(Collider{body, shape},
                           Boundary{side});
 
-            b2Body_SetUserData(body, new bagel::ent_type{entity.entity()});
+            b2Body_SetUserData(body, entity.entity().toUserData());
         }
 
         void MK::createBackground(const std::string& backgroundPath) const
     {
 
-        auto texture = TextureSystem::getTexture(ren, backgroundPath, TextureSystem::IgnoreColorKey::BACKGROUND);
+        const int texture = TextureSystem::loadAsync(pool, backgroundPath, TextureSystem::IgnoreColorKey::BACKGROUND);
 
         // Create fence
         bagel::Entity fence = bagel::Entity::create();
         fence.addAll(
             Position{0, 0},
             Texture{
-                texture,
+                nullptr,
                 { fenceX, fenceY, fenceW, fenceH }, // Only show the red/black part
                 { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT / 1.3f} // Stretch or place as needed
-            }
+            },
+            PendingTexture{texture},
+            RenderLayer{Layer::BACKGROUND, 0},
+            StaticLayer{StaticCache::BACKGROUND}
         );
 
         // Create temple
@@ -1381,10 +1913,13 @@ namespace mortal_kombat
         temple.addAll(
             Position{0, 0},
             Texture{
-                texture,
+                nullptr,
                 { templeX, templeY, templeW, templeH }, // Only show the red/black part
                 { 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT } // Stretch to fit window
-            }
+            },
+            PendingTexture{texture},
+            RenderLayer{Layer::BACKGROUND, 1}, // In front of the fence
+            StaticLayer{StaticCache::BACKGROUND}
         );
     }
 
@@ -1404,19 +1939,21 @@ namespace mortal_kombat
         constexpr float MARGIN = 50.0f;
         constexpr float xRight = WINDOW_WIDTH - BAR_WIDTH - MARGIN;
 
-        // Load the image as a surface
-        auto barTexture = TextureSystem::getTexture(ren, "res/Menus&Text.png", TextureSystem::IgnoreColorKey::DAMAGE_BAR);
-        auto nameTexture = TextureSystem::getTexture(ren, "res/Menus&Text.png", TextureSystem::IgnoreColorKey::NAME_BAR);
+        // Decoded in the background; RenderSystem fills the textures in once they are uploaded
+        menusTexture = TextureSystem::loadAsync(pool, "res/Menus&Text.png", TextureSystem::IgnoreColorKey::MENUS);
 
         // Player 1 - RED background bar
         bagel::Entity red1 = bagel::Entity::create();
         red1.addAll(
             Position{ MARGIN, OFFSET_Y },
             Texture{
-                barTexture,
+                nullptr,
                 RED_BAR_SRC,
                 SDL_FRect{ MARGIN, OFFSET_Y, BAR_WIDTH, BAR_HEIGHT }
-            }
+            },
+            PendingTexture{ menusTexture },
+            RenderLayer{ Layer::HUD, 0 },
+            StaticLayer{ StaticCache::HEALTH_BARS }
         );
 
         // Player 1 - GREEN health bar
@@ -1424,10 +1961,12 @@ namespace mortal_kombat
         green1.addAll(
             Position{ MARGIN, OFFSET_Y },
             Texture{
-                barTexture,
+                nullptr,
                 GREEN_BAR_SRC,
                 SDL_FRect{ MARGIN, OFFSET_Y, BAR_WIDTH, BAR_HEIGHT }
             },
+            PendingTexture{ menusTexture },
+            RenderLayer{ Layer::HUD, 1 },
             DamageVisual{100.0f},
             HealthBarReference{ player1.entity() }
         );
@@ -1437,10 +1976,13 @@ namespace mortal_kombat
         name1.addAll(
             Position{ MARGIN, OFFSET_Y },
             Texture{
-                nameTexture,
-                player1.get<Character>().leftBarNameSource,
+                nullptr,
+                player1.read<Character>().data->leftBarNameSource,
                 SDL_FRect{ MARGIN, OFFSET_Y, BAR_WIDTH, BAR_HEIGHT }
-            }
+            },
+            PendingTexture{ menusTexture },
+            RenderLayer{ Layer::HUD, 2 },
+            StaticLayer{ StaticCache::NAME_PLATES }
         );
 
         // Player 2 - RED background bar
@@ -1448,10 +1990,13 @@ namespace mortal_kombat
         red2.addAll(
             Position{ xRight, OFFSET_Y },
             Texture{
-                barTexture,
+                nullptr,
                 RED_BAR_SRC,
                 SDL_FRect{ xRight, OFFSET_Y, BAR_WIDTH, BAR_HEIGHT }
-            }
+            },
+            PendingTexture{ menusTexture },
+            RenderLayer{ Layer::HUD, 0 },
+            StaticLayer{ StaticCache::HEALTH_BARS }
         );
 
         // Player 2 - GREEN health bar
@@ -1459,10 +2004,12 @@ namespace mortal_kombat
         green2.addAll(
             Position{ xRight, OFFSET_Y },
             Texture{
-                barTexture,
+                nullptr,
                 GREEN_BAR_SRC,
                 SDL_FRect{ xRight, OFFSET_Y, BAR_WIDTH, BAR_HEIGHT }
             },
+            PendingTexture{ menusTexture },
+            RenderLayer{ Layer::HUD, 1 },
             DamageVisual{100.0f},
             HealthBarReference{ player2.entity() }
         );
@@ -1472,26 +2019,29 @@ namespace mortal_kombat
         name2.addAll(
             Position{ xRight, OFFSET_Y },
             Texture{
-                nameTexture,
-                player2.get<Character>().rightBarNameSource,
+                nullptr,
+                player2.read<Character>().data->rightBarNameSource,
                 SDL_FRect{ xRight, OFFSET_Y, BAR_WIDTH, BAR_HEIGHT }
-            }
+            },
+            PendingTexture{ menusTexture },
+            RenderLayer{ Layer::HUD, 2 },
+            StaticLayer{ StaticCache::NAME_PLATES }
         );
     }
 
     void MK::createWinText(const Character& winCharacter) const
     {
-        // Load the image as a surface
-        const auto texture = TextureSystem::getTexture(ren, "res/Menus&Text.png", TextureSystem::IgnoreColorKey::WIN_TEXT);
-
         // Create win text entity
-        bagel::Entity winText = bagel::Entity::create();
-        winText.addAll(
-            Position{(WINDOW_WIDTH / 2.0f) - (getWinSpriteFrame(winCharacter, 0).w / 1.3f), WINDOW_HEIGHT / 3.0f},
+        bagel::CommandBuffer& commands = bagel::World::commands();
+        bagel::ent_type winText = commands.create();
+        commands.addAll(winText,
+            Position{(WINDOW_WIDTH / 2.0f) - (getWinSpriteFrame(*winCharacter.data, 0).w / 1.3f), WINDOW_HEIGHT / 3.0f},
             winCharacter,
-            Texture{texture},
             Time{100000},
-            WinMessage{}
+            WinMessage{},
+            Texture{},
+            PendingTexture{menusTexture},
+            RenderLayer{Layer::OVERLAY}
         );
     }
 }
\ No newline at end of file
@@ -7,9 +7,11 @@
 
 #pragma once
 #include "mortal_kombat_info.h"
+#include <atomic>
+#include <deque>
 #include <functional>
 #include <string>
-#include <unordered_map>
+#include <vector>
 
 #include "SDL3/SDL.h"
 #include "box2d/box2d.h"
@@ -36,7 +38,8 @@ namespace mortal_kombat
         /// @brief Destructor. Cleans up resources.
         ~MK() {destroy();}
 
-        /// @brief Runs the main game loop.
+        /// @brief Runs the game until the window is closed.
+        /// The simulation gets its own thread; the calling thread owns the window and draws.
         void run() const;
 
         /// @brief Initializes the game.
@@ -66,11 +69,12 @@ namespace mortal_kombat
 
         static constexpr int CHAR_SQUARE_WIDTH = 230;
         static constexpr int CHAR_SQUARE_HEIGHT = 220;
-        static constexpr int NEXT_FRAME_OFFSET = 4;
-        static constexpr int SHADOW_OFFSET = 8;
 
         static constexpr int NONE = -1;
 
+        // Upper bound on live entities; storages are pre-sized to it at match start
+        static constexpr int MAX_ENTITIES = 256;
+
         static constexpr int PLAYER_1_BASE_X = WINDOW_WIDTH / 4 - (CHAR_SQUARE_WIDTH / 2) - 100;
         static constexpr int PLAYER_2_BASE_X = (WINDOW_WIDTH / 4) * 3 - (CHAR_SQUARE_WIDTH / 2);
         static constexpr int PLAYER_BASE_Y = WINDOW_HEIGHT / 2.0f - 20;
@@ -94,14 +98,67 @@ namespace mortal_kombat
 
 
         SDL_Renderer* ren{};
-        mutable SDL_Texture* winTextTexture = nullptr;
+        mutable int menusTexture = NONE; // TextureSystem handle of the HUD and win text sheet
         SDL_Window* win{};
         b2WorldId boxWorld{};
 
+        // Shared by the scheduler and asset loading; internally synchronized
+        mutable bagel::ThreadPool pool;
+
+        /**
+         * @class PhysicsTasks
+         * @brief Box2D's task callbacks, running its parallel loops on a pool of their own.
+         *
+         * The solver enqueues one task per worker, and all but the first spin until the first
+         * finishes the step. Its pool has a thread for each of those tasks, counting the thread
+         * stepping the world, and nothing else queues there. Busy scheduler threads therefore
+         * can't hold the first task back while the rest spin.
+         * Box2D numbers its per-thread scratch by worker index, so each range gets this pool's
+         * index of the thread running it: its workers, plus the thread stepping the world.
+         */
+        class PhysicsTasks {
+        public:
+            PhysicsTasks() : pool(std::min(bagel::ThreadPool::defaultWorkers(), MAX_WORKERS - 1)) {}
+
+            /// @brief Hooks the callbacks into a world definition, unless the pool has no workers.
+            void install(b2WorldDef& def);
+
+            /// @brief Frees the task slots; call before each b2World_Step.
+            void reset() { used = 0; }
+
+        private:
+            static constexpr int MAX_WORKERS = 64; // B2_MAX_WORKERS
+            // A few dozen loops per step, plus the solver's one per worker. Those must never
+            // run inline on the stepping thread, where they would spin forever
+            static constexpr int MAX_TASKS = 64 + MAX_WORKERS;
+
+            struct Task {
+                bagel::ParallelFor loop;
+                b2TaskCallback* callback;
+                void* context;
+            };
+
+            static void* enqueue(b2TaskCallback* callback, int itemCount, int minRange, void* taskContext, void* userContext);
+            static void finish(void* userTask, void* userContext);
+
+            bagel::ThreadPool pool;
+            std::array<Task, MAX_TASKS> tasks;
+            int used = 0; // Only the thread stepping the world enqueues
+        };
+
+        // The system stepping the world owns it while it runs
+        mutable PhysicsTasks physicsTasks;
+
+        // Entities of this match; bound as the thread's current world for MK's lifetime,
+        // and as the simulation thread's while run() is going
+        mutable bagel::World world;
+        bagel::World::Scope worldScope{world};
+
         /* =============== Components =============== */
         /// @brief Position component holds the x and y coordinates of an object.
         struct Position {
             float x = 0.0f, y = 0.0f;
+            static constexpr bool TrackChanges = true; // Stamped on write, see bagel::View::changedSince
         };
 
         /// @brief Movement component holds the velocity of the entity.
@@ -110,11 +167,94 @@ namespace mortal_kombat
             void reset() {vx = vy = 0;}
         };
 
+        /**
+         * @class SpriteAtlas
+         * @brief A fighter atlas cooked by mk_cook and its remapped frame table.
+         *
+         * Only the frames referenced by the sprite tables are kept, trimmed to their opaque
+         * bounds and with the color key already turned into alpha. The atlas is 8-bit indexed,
+         * so every PaletteSwap is just another palette for the same texture.
+         */
+        class SpriteAtlas {
+        public:
+            SDL_Texture *tex = nullptr;
+
+            /// @brief Reads a frame table written by mk_cook.
+            /// @return false if the file is missing or malformed.
+            bool loadTable(const std::string& path);
+
+            /// @brief Returns the cooked frame for a state, wrapping like MK::getSpriteFrame.
+            const AtlasFrame& frame(State state, int frame) const {
+                return pick(states[static_cast<int>(state)], frame);
+            }
+
+            /// @brief Returns the cooked frame for a special attack, wrapping like MK::getSpriteFrame.
+            const AtlasFrame& frame(SpecialAttacks attack, int frame) const {
+                return pick(specials[static_cast<int>(attack)], frame);
+            }
+
+            /// @brief Derives every PaletteSwap from the atlas palette.
+            /// @param base Palette of the indexed atlas surface.
+            void buildPalettes(const SDL_Palette* base);
+
+            /// @brief Returns the palette for a swap, or nullptr if the atlas is not indexed.
+            SDL_Palette* palette(PaletteSwap swap) const {
+                return palettes[static_cast<int>(swap)];
+            }
+
+            void releasePalettes();
+
+        private:
+            static const AtlasFrame& pick(const std::vector<AtlasFrame>& frames, int frame) {
+                static constexpr AtlasFrame EMPTY{};
+                return frames.empty() ? EMPTY : frames[frame % frames.size()];
+            }
+
+            std::array<std::vector<AtlasFrame>, CHARACTER_SPRITE_SIZE> states;
+            std::array<std::vector<AtlasFrame>, SPECIAL_ATTACK_SPRITE_SIZE> specials;
+            std::array<SDL_Palette*, static_cast<int>(PaletteSwap::COUNT)> palettes{};
+        };
+
         /// @brief Texture component holds the SDL texture and its rectangle for rendering.
+        /// The simulation only knows the handle; tex is filled in by the render thread.
         struct Texture {
             SDL_Texture *tex = nullptr;
             SDL_FRect srcRect = {0, 0, 0, 0}; // Source rectangle for texture
             SDL_FRect rect = {0, 0, 0, 0}; // Destination rectangle for rendering
+            const SpriteAtlas *atlas = nullptr; // Frame table when tex is a cooked atlas
+            SDL_Palette *palette = nullptr; // Palette to draw tex with, when tex is indexed
+            int handle = NONE; // TextureSystem handle of tex, used to group draws
+        };
+
+        /// @brief Draw layers, back to front.
+        enum class Layer : Uint8 {
+            BACKGROUND,
+            FIGHTERS,
+            PROJECTILES,
+            HUD,
+            OVERLAY,
+        };
+
+        /// @brief Sprites composited together by a StaticLayerCache; each is drawn at one spot in the order.
+        enum class StaticCache : Uint8 {
+            BACKGROUND,
+            HEALTH_BARS,
+            NAME_PLATES,
+            COUNT
+        };
+
+        /// @brief StaticLayer component marks a sprite that never animates.
+        /// It is drawn through its cache's composite instead of its own sheet.
+        struct StaticLayer {
+            StaticCache cache = StaticCache::BACKGROUND;
+        };
+
+        /// @brief RenderLayer component places an entity in the draw order.
+        /// Sprites are drawn by layer, then grouped by texture, then by z; z only orders
+        /// sprites sharing a texture, so use layers where overlap between textures matters.
+        struct RenderLayer {
+            Layer layer = Layer::BACKGROUND;
+            Uint16 z = 0;
         };
 
         /// @brief Collider component holds the physics body and shape.
@@ -141,6 +281,7 @@ namespace mortal_kombat
             int currFrame = 0; //  Frames spent in the current state
             int freezeFrame = NONE; // Frame to freeze the player
             int freezeFrameDuration = 0; // Duration of the freeze-frame
+            static constexpr bool TrackChanges = true;
 
             /// @brief Resets the player state to default values.
             void reset()
@@ -244,27 +385,9 @@ namespace mortal_kombat
             }
         };
 
-        /// @brief Attack component holds the attack type, damage, hitbox, and hitbox type.
-        struct Attack {
-            State type;
-            int attacker;
-
-            static constexpr int ATTACK_LIFE_TIME = 1;
-        };
-
-        /// @brief SpecialAttack component holds the special move type and inputs for the attack.
-        struct SpecialAttack {
-            SpecialAttacks type = SpecialAttacks::NONE;
-            bool direction = RIGHT;
-            int frame = 0;
-            int totalFrames = 0;
-            bool explode = false;
-
-            static constexpr int SPECIAL_ATTACK_LIFE_TIME = 70;
-        };
-
-        /// @brief Character component holds the character information of the player.
-        struct Character {
+        /// @brief Everything fixed about a fighter: sprites, frame data, special move inputs.
+        /// One read-only instance per fighter lives in Characters; entities point at it.
+        struct CharacterData {
             static constexpr int SPECIAL_ATTACKS_COUNT = 3;
             static constexpr int COMBO_LENGTH = 3;
 
@@ -277,17 +400,32 @@ namespace mortal_kombat
             SDL_FRect leftBarNameSource{};
             SDL_FRect rightBarNameSource{};
             SpriteInfo winText;
+            // Source rects precomputed from the tables above
+            FrameTableRef<State> spriteFrames;
+            FrameTableRef<SpecialAttacks> specialAttackFrames;
+            FrameSpan winFrames;
+            FrameBoxTableRef frameBoxes;
+        };
+
+        /// @brief Character component holds which fighter an entity is and how this match draws it.
+        /// The fighter's tables are shared through data rather than copied into every entity.
+        struct Character {
+            const CharacterData* data = nullptr; // One of Characters
+            int texture = NONE; // TextureSystem handle of the sprite sheet, set by createPlayer
+            PaletteSwap palette = PaletteSwap::NONE; // Recolor of the fighter and its projectiles
         };
 
         /// @brief Health component holds the maximum and current health of the player.
         struct Health {
             float max_health = 100.0f;
             float health = 100.0f;
+            static constexpr bool TrackChanges = true;
         };
 
         /// @brief Time component holds the time remaining in the match.
         struct Time {
             float time = 0.0f;
+            static constexpr bool TrackChanges = true;
         };
 
         /// @brief Boundary tag component is used to identify boundary entities.
@@ -303,13 +441,20 @@ namespace mortal_kombat
 
         /// @brief HealthBarReference component holds a reference to the actual player entity.
         struct HealthBarReference {
-            bagel::ent_type target;  // Reference to actual player entity
+            bagel::ent_type target;  // Weak reference to the player entity, checked with World::alive
         };
 
         /// @brief Tag to indicate this is a win message UI entity.
         struct WinMessage {
         };
 
+        /// @brief PendingTexture component holds the handle of a texture not resolved yet.
+        /// SnapshotSystem swaps it into the entity's Texture once it has been decoded.
+        struct PendingTexture {
+            int handle = NONE; // Returned by TextureSystem::loadAsync
+            PaletteSwap palette = PaletteSwap::NONE; // Only applies to cooked fighter atlases
+        };
+
         /* =============== Systems =============== */
 
         /// @brief Updates the position of entities based on their movement components.
@@ -327,8 +472,16 @@ namespace mortal_kombat
             return {x / WINDOW_SCALE, y / WINDOW_SCALE};
         }
 
-        /// @brief Renders entities with position and texture components to the screen.
-        void RenderSystem() const;
+        /// @brief Publishes this tick's RenderSnapshot of the entities with position and texture components.
+        void SnapshotSystem() const;
+
+        /// @brief Polls events, hands the keyboard to the simulation and draws the newest snapshot.
+        /// Runs on the thread that owns the window.
+        /// @return false once the window was closed or Escape pressed.
+        bool RenderSystem() const;
+
+        /// @brief Runs the systems FPS times a second until quit is set.
+        void simulate() const;
 
         /// @brief Returns the sprite rectangle for a given action and frame.
         /// @param character Character data for the player.
@@ -336,21 +489,37 @@ namespace mortal_kombat
         /// @param frame Frame number of the action.
         /// @param shadow Whether to return shadow.
         /// @return SDL_FRect representing the sprite rectangle.
-        static SDL_FRect getSpriteFrame(const Character& character, State action,
-                                            int frame, bool shadow = false);
+        static const SDL_FRect& getSpriteFrame(const CharacterData& character, State action,
+                                            int frame, bool shadow = false) {
+            return character.spriteFrames[action](frame, shadow);
+        }
 
         /// @brief Returns the sprite rectangle for a given action and frame.
         /// @param character Character data for the player.
         /// @param action Action state of the SpecialAttack.
         /// @param frame Frame number of the action.
         /// @return SDL_FRect representing the sprite rectangle.
-        static SDL_FRect getSpriteFrame(const Character& character, SpecialAttacks action,
-                                            int frame);
+        static const SDL_FRect& getSpriteFrame(const CharacterData& character, SpecialAttacks action,
+                                            int frame) {
+            return character.specialAttackFrames[action](frame);
+        }
 
         /// @brief Returns the sprite rectangle for a given action and frame.
         /// @param character Character data for the player.
         /// @param frame Frame number of the action.
-        static SDL_FRect getWinSpriteFrame(const Character &character, int frame) ;
+        static const SDL_FRect& getWinSpriteFrame(const CharacterData &character, int frame) {
+            return character.winFrames(frame);
+        }
+
+        /// @brief Points a texture at a cooked frame, placing the trimmed rect where it sat in its cell.
+        /// @param texture Texture to update.
+        /// @param frame Cooked frame from the texture's atlas.
+        /// @param position Top left of the untrimmed sprite on screen.
+        /// @param w Width of the untrimmed sprite.
+        /// @param h Height of the untrimmed sprite.
+        /// @param flipMode Flip the sprite will be drawn with.
+        static void setAtlasFrame(Texture& texture, const AtlasFrame& frame, const Position& position,
+                                  float w, float h, SDL_FlipMode flipMode);
 
         /// @brief Manages player-specific logic, such as state and character updates.
         void PlayerSystem() const;
@@ -361,21 +530,33 @@ namespace mortal_kombat
         /// @brief Updates the game clock and manages time-related logic.
         static void ClockSystem();
 
-        /// @brief Processes player inputs and updates input history.
-        static void InputSystem();
+        using KeyboardState = std::array<bool, SDL_SCANCODE_COUNT>;
 
-        /// @brief Manages special attack detection.
-        static void SpecialAttackSystem();
+        /// @brief Processes player inputs and updates input history.
+        /// @param keyboardState Keys held at the render thread's last event poll.
+        static void InputSystem(const KeyboardState& keyboardState);
 
         /// @brief Handles combat logic, such has damage application, and player hit state.
-        /// @param eAttack Entity representing the attack.
+        /// @param attack State of the attack that connected.
         /// @param ePlayer Entity representing the attacked player.
-        static void CombatSystem(bagel::Entity &eAttack, bagel::Entity &ePlayer);
+        /// @return false if the player blocked or evaded the attack.
+        static bool CombatSystem(State attack, bagel::Entity &ePlayer);
+
+        /// @brief Tests every fighter's hit box, from the frame data, against the others' hurt boxes.
+        /// All overlaps are found before any is applied, so hits traded on the same frame both land.
+        void HitSystem() const;
 
-        /// @brief Handles attack's entity destruction and decay logic.
-        static void AttackDecaySystem();
+        struct Hit {
+            bagel::ent_type victim;
+            State attack;
+        };
+        mutable std::vector<Hit> hits; // HitSystem's; reserved in start so landing a hit never allocates
 
-        /// @brief Handles and store a cache of SDL textures.
+        /// @brief Steps every projectile in one pass, lands the ones touching an opponent and drops expired ones.
+        void ProjectileSystem() const;
+
+        /// @brief Registry of SDL textures, addressed by dense integer handles.
+        /// Paths are only looked at when a texture is registered; everything after goes by handle.
         class TextureSystem
         {
         public:
@@ -383,24 +564,74 @@ namespace mortal_kombat
             {
                 CHARACTER,
                 BACKGROUND,
-                NAME_BAR,
-                DAMAGE_BAR,
-                WIN_TEXT,
+                MENUS, // Every region of the sheet has its own key, see MENUS_REGIONS
             };
-            /// @brief Loads a texture from a file and caches it for future use.
-            static SDL_Texture* getTexture(SDL_Renderer* renderer, const std::string& filePath, IgnoreColorKey ignoreColorKey);
-
-            /// @brief Clears the texture cache and destroys all cached textures.
-            static void clearCache() {
-                for (auto& pair : textureCache) {
-                    SDL_DestroyTexture(pair.second);
-                }
-                textureCache.clear();
+            /// @brief Registers a texture and starts decoding it on the pool; uploadLoaded creates it on the main thread.
+            /// Registering the same file and key again returns the same handle. Textures are registered
+            /// while setting up the match, before the simulation thread starts.
+            /// @return Handle to pass to loaded, or to a PendingTexture component.
+            static int loadAsync(bagel::ThreadPool& pool, const std::string& filePath, IgnoreColorKey ignoreColorKey);
+
+            /// @brief Same as loadAsync for a fighter, preferring its cooked atlas over the raw sheet.
+            static int loadCharacterAsync(bagel::ThreadPool& pool, const std::string& name);
+
+            /// @brief Uploads every finished decode. Main thread only.
+            static void uploadLoaded(SDL_Renderer* renderer);
+
+            /// @brief Blocks until every texture has been uploaded, running queued decodes meanwhile.
+            static void finishLoading(SDL_Renderer* renderer);
+
+            /// @brief Returns the texture behind a handle, or nullptr while it is still in flight.
+            /// Main thread only.
+            static const Texture* loaded(int handle) {
+                return registry[handle].uploaded ? &registry[handle].texture : nullptr;
+            }
+
+            /// @brief Whether a handle's decode has finished; safe to call from any thread.
+            static bool decoded(int handle) {
+                return registry[handle].decoded.load(std::memory_order_acquire);
             }
+
+            /// @brief Frame table of a decoded fighter atlas, or nullptr for plain textures.
+            /// Only valid once decoded returned true; the atlas does not change after that.
+            static const SpriteAtlas* atlas(int handle) {
+                return registry[handle].cooked ? &registry[handle].atlas : nullptr;
+            }
+
+            /// @brief Destroys every registered texture; handles are invalid afterwards.
+            static void clearCache();
         private:
-            static constexpr Uint8 CHARACTER_COLOR_IGNORE_RED = 165;
-            static constexpr Uint8 CHARACTER_COLOR_IGNORE_GREEN = 231;
-            static constexpr Uint8 CHARACTER_COLOR_IGNORE_BLUE = 255;
+            /// A registered texture, decoded on the pool and uploaded by uploadLoaded.
+            struct Entry {
+                std::string name; // File path, or fighter name for character loads
+                IgnoreColorKey ignoreColorKey = IgnoreColorKey::CHARACTER;
+                bool character = false;
+
+                // Written by the decoding worker, published through decoded
+                SDL_Surface* surface = nullptr;
+                SpriteAtlas atlas;
+                bool cooked = false;
+                std::atomic<bool> decoded{false};
+
+                bool uploaded = false;
+                Texture texture;
+            };
+
+            /// @brief Loads an image and applies the color key; safe to call from any thread.
+            static SDL_Surface* decode(const std::string& filePath, IgnoreColorKey ignoreColorKey);
+
+            /// @brief Loads a fighter's cooked atlas and its table; safe to call from any thread.
+            /// @return nullptr if the fighter has not been cooked.
+            static SDL_Surface* decodeAtlas(const std::string& name, SpriteAtlas& atlas);
+
+            /// @brief Creates a texture from a decoded surface and destroys the surface.
+            static SDL_Texture* upload(SDL_Renderer* renderer, SDL_Surface* surface, const std::string& filePath);
+
+            static void waitForDecodes();
+
+            static constexpr Uint8 CHARACTER_COLOR_IGNORE_RED = CHARACTER_COLOR_KEY[0];
+            static constexpr Uint8 CHARACTER_COLOR_IGNORE_GREEN = CHARACTER_COLOR_KEY[1];
+            static constexpr Uint8 CHARACTER_COLOR_IGNORE_BLUE = CHARACTER_COLOR_KEY[2];
 
             static constexpr Uint8 BACKGROUND_COLOR_IGNORE_RED = 252;
             static constexpr Uint8 BACKGROUND_COLOR_IGNORE_GREEN = 0;
@@ -420,10 +651,246 @@ namespace mortal_kombat
             static constexpr Uint8 WIN_TEXT_COLOR_IGNORE_GREEN = 10;
             static constexpr Uint8 WIN_TEXT_COLOR_IGNORE_BLUE = 237;
 
+            /// A rect of a sheet with its own color key.
+            struct KeyedRegion {
+                SDL_Rect rect;
+                Uint8 red, green, blue;
+            };
+
+            // Menus&Text.png is shared by the bars, name plates and win texts, which use
+            // different background colors; each key is only cleared inside its own region
+            static constexpr KeyedRegion MENUS_REGIONS[] = {
+                {{5406, 49, 163, 26}, COLOR_KEY_DAMAGE_BAR_RED, COLOR_KEY_DAMAGE_BAR_GREEN, COLOR_KEY_DAMAGE_BAR_BLUE},
+                {{5406, 142, 336, 43}, COLOR_KEY_NAME_BAR_RED, COLOR_KEY_NAME_BAR_GREEN, COLOR_KEY_NAME_BAR_BLUE},
+                {{3714, 15, 666, 468}, WIN_TEXT_COLOR_IGNORE_RED, WIN_TEXT_COLOR_IGNORE_GREEN, WIN_TEXT_COLOR_IGNORE_BLUE},
+            };
+
+            /// @brief Clears the alpha of every pixel of the region that matches its key.
+            /// @param surface Surface in SDL_PIXELFORMAT_RGBA32.
+            static void bakeColorKey(SDL_Surface* surface, const KeyedRegion& region);
+
+            static std::deque<Entry> registry; // Indexed by handle; a deque so entries never move
+            static bagel::ThreadPool* loadPool;
+        };
+
+        /**
+         * @class SpriteBatch
+         * @brief Collects textured quads and submits them with SDL_RenderGeometry.
+         *
+         * Consecutive quads that share a texture go out in a single call, so the number
+         * of draw calls depends on texture switches rather than on the sprite count.
+         */
+        class SpriteBatch {
+        public:
+            /// @brief Queues a quad, submitting the pending ones first if the texture or palette changes.
+            /// Horizontal flips swap the quad's u coordinates.
+            /// @param palette Palette to draw an indexed tex with, nullptr to keep its own.
+            void add(SDL_Renderer* renderer, SDL_Texture* tex, SDL_Palette* palette, const SDL_FRect& src,
+                     const SDL_FRect& dst, SDL_FlipMode flipMode);
+
+            /// @brief Submits the pending quads.
+            void flush(SDL_Renderer* renderer);
+
+        private:
+            SDL_Texture* texture = nullptr;
+            SDL_Palette* palette = nullptr;
+            std::vector<SDL_Vertex> vertices;
+            std::vector<int> indices;
+        };
+
+        /**
+         * @class RenderQueue
+         * @brief Collects the visible sprites of a frame and sorts them into draw order.
+         *
+         * Items are keyed by (layer, texture, z) and sorted with a stable LSD radix sort, so
+         * draw order no longer depends on entity ids and texture switches are minimal.
+         */
+        class RenderQueue {
+        public:
+            struct Item {
+                Uint32 key;
+                const Texture* texture;
+                SDL_FlipMode flipMode;
+            };
+
+            /// @brief Sort key of a sprite: 4 bits of layer, 12 of texture handle, 16 of z.
+            static Uint32 keyOf(const RenderLayer& layer, const Texture& texture);
+
+            void push(Uint32 key, const Texture& texture, SDL_FlipMode flipMode) {
+                items.push_back({key, &texture, flipMode});
+            }
+
+            /// @brief Sorts the queued items by key; ties keep their push order.
+            const std::vector<Item>& sort();
+
+            void clear() { items.clear(); }
+
+        private:
+            std::vector<Item> items, scratch;
+        };
+
+        /**
+         * @class StaticLayerCache
+         * @brief Composites sprites that never animate into one window-sized render target.
+         *
+         * Members are collected again every frame, but the target is only redrawn when their
+         * textures, rects or membership change. It then stands in for all of them in the queue.
+         */
+        class StaticLayerCache {
+        public:
+            /// @brief Starts collecting this frame's members.
+            void begin();
+
+            void add(bagel::ent_type entity, Uint32 key, const Texture& texture);
+
+            /// @brief Redraws the target if the members changed since it was last built.
+            /// @return false if the cache has no members and should not be drawn.
+            bool update(SDL_Renderer* renderer, SpriteBatch& batch);
 
-            static std::unordered_map<std::string, SDL_Texture*> textureCache;
+            /// @brief Sort key of the composite, taken from its backmost member.
+            Uint32 key() const { return first; }
+
+            const Texture& texture() const { return composite; }
+
+            void release();
+
+        private:
+            struct Member {
+                Uint32 key;
+                const Texture* texture;
+            };
+
+            static constexpr Uint64 FNV_OFFSET_BASIS = 14695981039346656037ull;
+
+            std::vector<Member> members;
+            Uint64 signature = FNV_OFFSET_BASIS, builtSignature = 0;
+            Uint32 first = 0;
+            Texture composite;
+        };
+
+        /**
+         * @struct RenderSnapshot
+         * @brief Everything the render thread needs to draw one simulation tick.
+         *
+         * SnapshotSystem fills one per tick and hands it over through a TripleBuffer, so drawing
+         * never touches the world and a slow present or vsync wait can't hold the simulation back.
+         */
+        struct RenderSnapshot {
+            struct Sprite {
+                Uint32 key; // RenderQueue::keyOf
+                bagel::ent_type entity;
+                int handle; // TextureSystem handle, resolved to its SDL texture when drawing
+                SDL_Palette* palette;
+                SDL_FRect srcRect, rect;
+                SDL_FlipMode flipMode;
+                StaticCache cache; // COUNT unless the sprite goes into a StaticLayerCache
+            };
+            std::vector<Sprite> sprites;
+        };
+
+        mutable bagel::TripleBuffer<RenderSnapshot> snapshots; // Simulation to render thread
+        mutable bagel::TripleBuffer<KeyboardState> keyboard;   // Render to simulation thread
+        mutable std::atomic<bool> quit{false};
+
+        // Render thread only. Kept across frames so their buffers stay allocated
+        mutable RenderQueue renderQueue;
+        mutable SpriteBatch spriteBatch;
+        mutable std::array<StaticLayerCache, static_cast<int>(StaticCache::COUNT)> staticLayers;
+        mutable std::vector<Texture> drawn; // The snapshot's sprites with their textures resolved
+
+        /**
+         * @class Projectiles
+         * @brief Every live fireball, kept as parallel arrays instead of one entity each.
+         *
+         * A projectile is only a box, a speed, a lifetime and a frame, and all of them step the
+         * same way; contiguous arrays let update run as flat loops the compiler can vectorize.
+         * Sprite data is looked up from the shooter by player number, never copied per projectile.
+         * The arrays are reserved up front and reused, so spawning never allocates.
+         */
+        class Projectiles {
+        public:
+            static constexpr int MAX_PROJECTILES = 1 << 15; // Enough for the bullet-hell training mode
+            // Ticks left, counted down like the old Time component: still drawn on the tick it
+            // reaches 0, gone on the next
+            static constexpr int LIFE_TIME = 70;
+            static constexpr int EXPLOSION_TIME = 4; // Held on its first frame
+            static constexpr float SPEED = 15.0f;
+
+            /// @brief Indexed by player number; slot 0 is unused.
+            using HurtBoxes = std::array<HitBox, 3>;
+
+            /// @brief What a fighter's projectiles are drawn with.
+            struct Shooter {
+                const CharacterData* data = nullptr;
+                int texture = NONE;
+                PaletteSwap palette = PaletteSwap::NONE;
+            };
+
+            /// @brief One projectile as SnapshotSystem needs it.
+            struct Sprite {
+                float x, y;
+                SpecialAttacks type;
+                int frame;
+                int playerNumber;
+                bool direction;
+            };
+
+            Projectiles();
+
+            /// @brief Takes the sprite data of a fighter's projectiles; call once the texture handle is set.
+            void setShooter(int playerNumber, const Character& character);
+            const Shooter& shooter(int playerNumber) const { return shooters[playerNumber]; }
+
+            /// @brief Launches a projectile from a fighter standing at x,y. Dropped when the pool is full.
+            void spawn(float x, float y, SpecialAttacks type, int playerNumber, bool direction);
+
+            /// @brief Moves, ages and animates every projectile and tests it against the fighters' hurt boxes.
+            /// @return Whether any projectile touched a fighter it can still hurt; see resolveHits.
+            bool update(const HurtBoxes& hurt);
+
+            /// @brief Calls land(playerNumber) once for each fighter a projectile touched on the last update.
+            /// A projectile never hurts the same fighter twice, and explodes when land returns true.
+            template <class F>
+            void resolveHits(F&& land) {
+                for (size_t i = 0; i < hits.size(); ++i)
+                    for (int player = 1; player <= 2; ++player)
+                        if (hits[i] & (1 << player)) {
+                            targets[i] &= static_cast<Uint8>(~(1 << player));
+                            if (land(player))
+                                explode(i);
+                        }
+            }
+
+            /// @brief Drops the projectiles whose lifetime ran out, keeping the others in order.
+            void compact();
+
+            template <class F>
+            void each(F&& f) const {
+                for (size_t i = 0; i < x.size(); ++i)
+                    f(Sprite{x[i], y[i], type[i], frame[i], shooterOf[i], direction[i] != 0});
+            }
+
+            size_t size() const { return x.size(); }
+
+        private:
+            void explode(size_t i);
+
+            std::array<Shooter, 3> shooters; // By player number
+
+            // One entry per projectile in each
+            std::vector<float> x, y, vx;
+            std::vector<float> boxX, boxY, boxW, boxH; // Hurt box test, offset from x and y
+            std::vector<int> life;
+            std::vector<Uint8> frame, lastFrame;
+            std::vector<SpecialAttacks> type;
+            std::vector<Uint8> shooterOf, direction;
+            std::vector<Uint8> targets; // Bit n set while the projectile can still hurt player n
+            std::vector<Uint8> hits;    // Bit n set when the last update found it touching player n
         };
 
+        // Simulation thread only; systems using it declare it as a resource
+        mutable Projectiles projectiles;
+
         static void HealthBarSystem();
 
         /* =============== Entities =============== */
@@ -435,22 +902,6 @@ namespace mortal_kombat
         /// @param playerNumber Player number (1 or 2).
         bagel::ent_type createPlayer(float x, float y, Character character, int playerNumber) const;
 
-        /// @brief Creates an Attack entity (like a punch or kick).
-        /// @param x,y Position of the entity in the game world.
-        /// @param type Type of the attack.
-        /// @param playerNumber Player number (1 or 2).
-        /// @param direction attack direction.
-        void createAttack(float x, float y, State type, int playerNumber, bool direction) const;
-
-        /// @brief Creates a special attack entity.
-        /// @param x,y Position of the entity in the game world.
-        /// @param type Type of the special attack.
-        /// @param playerNumber Player number (1 or 2).
-        /// @param direction attack direction.
-        /// @param character Character data for the player.
-        void createSpecialAttack(float x, float y, SpecialAttacks type, int playerNumber,
-                                bool direction, Character& character) const;
-
         /// @brief Creates a static platform/boundary.
         /// @param side boundary side (left or right).
         void createBoundary(bool side) const;
@@ -465,7 +916,7 @@ namespace mortal_kombat
         /// @param player2 Player 2 entity.
         void createBar(bagel::Entity player1, bagel::Entity player2) const;
 
-        /// @brief Creates a win text entity.
+        /// @brief Records a win text entity, spawned at the next sync point.
         /// @param winCharacter Character data for the winning player.
         void createWinText(const Character& winCharacter) const;
 
@@ -473,12 +924,13 @@ namespace mortal_kombat
          * @struct Characters
          * @brief Represents the characters in the game.
          *
-         * Contains all relevant data for a character, including name, health, position, and state.
-         * Used for managing character logic, rendering, and interactions in the game world.
+         * Contains all relevant data for a character, including name, sprites and frame data.
+         * These are the only copies: they are read-only, and every fighter, projectile and win
+         * text refers to one through Character::data.
          */
         struct Characters
         {
-            constexpr static Character SUBZERO = {
+            constexpr static CharacterData SUBZERO = {
                 .name = "Sub-Zero",
                 .sprite = SUBZERO_SPRITE,
                 .specialAttackSprite = SUBZERO_SPECIAL_ATTACK_SPRITE,
@@ -488,9 +940,13 @@ namespace mortal_kombat
                 .leftBarNameSource = { 5406, 173, 163, 12 },
                 .rightBarNameSource = { 5579, 173, 163, 12 },
                 .winText = WIN_SPRITE[CharacterType::SUBZERO],
+                .spriteFrames = SUBZERO_FRAMES,
+                .specialAttackFrames = SUBZERO_SPECIAL_ATTACK_FRAMES,
+                .winFrames = WIN_FRAMES[CharacterType::SUBZERO],
+                .frameBoxes = SUBZERO_FRAME_BOXES,
             };
 
-            constexpr static Character LIU_KANG = {
+            constexpr static CharacterData LIU_KANG = {
                 .name = "Liu Kang",
                 .sprite = LIU_KANG_SPRITE,
                 .specialAttackSprite = LIU_SPECIAL_ATTACK_SPRITE,
@@ -500,6 +956,10 @@ namespace mortal_kombat
                 .leftBarNameSource = { 5406, 142, 163, 12 },
                 .rightBarNameSource = { 5579, 142, 163, 12 },
                 .winText = WIN_SPRITE[CharacterType::LIU_KANG],
+                .spriteFrames = LIU_KANG_FRAMES,
+                .specialAttackFrames = LIU_SPECIAL_ATTACK_FRAMES,
+                .winFrames = WIN_FRAMES[CharacterType::LIU_KANG],
+                .frameBoxes = LIU_KANG_FRAME_BOXES,
             };
         };
 
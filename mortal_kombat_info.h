@@ -7,6 +7,7 @@
 
 #pragma once
 #include <array>
+#include <SDL3/SDL_rect.h>
 
 namespace mortal_kombat
 {
@@ -88,6 +89,14 @@ namespace mortal_kombat
     static constexpr int SPECIAL_ATTACK_SPRITE_SIZE = 2;
     static constexpr int WIN_SPRITE_BY_CHARACTER_SIZE = 9;
 
+    /// Gap between neighbouring frames in the raw sprite sheets.
+    static constexpr int NEXT_FRAME_OFFSET = 4;
+    /// Gap between a frame and its shadow row in the raw sprite sheets.
+    static constexpr int SHADOW_OFFSET = 8;
+
+    /// Background color of the raw fighter sheets, cooked into alpha by mk_cook.
+    static constexpr unsigned char CHARACTER_COLOR_KEY[3] = {165, 231, 255};
+
     /// @brief SpriteInfo struct holds the sprite information.
     struct SpriteInfo {
         int frameCount = 0;
@@ -95,6 +104,38 @@ namespace mortal_kombat
         float w = 230, h = 220;
     };
 
+    /**
+     * @struct AtlasFrame
+     * @brief A trimmed frame inside a cooked sprite atlas.
+     *
+     * The frame only covers the opaque bounds of the original cell, so it also records
+     * where those bounds sit inside the cell and how large the cell was.
+     */
+    struct AtlasFrame {
+        float x = 0, y = 0, w = 0, h = 0;   // Rect in the atlas
+        float offsetX = 0, offsetY = 0;     // Top left of the rect inside the original cell
+        float cellW = 0, cellH = 0;         // Size of the original cell
+    };
+
+    /// First line of a cooked frame table.
+    static constexpr const char* ATLAS_TABLE_HEADER = "MKATLAS 1";
+    /// Frame table lines are tagged by the enum they index.
+    static constexpr char ATLAS_STATE_GROUP = 'S';
+    static constexpr char ATLAS_SPECIAL_GROUP = 'A';
+    /// Cooked atlases are 8-bit indexed; this entry of their palette is transparent.
+    static constexpr int ATLAS_TRANSPARENT_INDEX = 0;
+    static constexpr int ATLAS_PALETTE_SIZE = 256;
+
+    /// @brief Alternate palettes of the cooked fighter atlases, the classic ninja recolors.
+    /// Each one moves the blue costume colors to another hue; the rest of the palette is kept.
+    enum class PaletteSwap
+    {
+        NONE,
+        YELLOW, // Sub-Zero's blue to Scorpion's yellow
+        GREEN,  // Sub-Zero's blue to Reptile's green
+        COUNT
+    };
+
     /**
      * @class SpriteData
      * @brief Holds the sprite data for a character.
@@ -105,6 +146,7 @@ namespace mortal_kombat
     template<class T, size_t SIZE>
     class SpriteData {
     public:
+        constexpr SpriteData() = default;
         explicit constexpr SpriteData(const std::array<SpriteInfo, SIZE>& spriteArray)
                     : sprite(spriteArray) {}
 
@@ -252,4 +294,196 @@ namespace mortal_kombat
     static constexpr SpriteData<SpecialAttacks, SPECIAL_ATTACK_SPRITE_SIZE> SUBZERO_SPECIAL_ATTACK_SPRITE(SUBZERO_SPECIAL_SPRITE_ARRAY);
     static constexpr SpriteData<SpecialAttacks, SPECIAL_ATTACK_SPRITE_SIZE> LIU_SPECIAL_ATTACK_SPRITE(LIU_KANG_SPECIAL_SPRITE_ARRAY);
     static constexpr SpriteData<CharacterType, WIN_SPRITE_BY_CHARACTER_SIZE> WIN_SPRITE(WIN_SPRITE_BY_CHARACTER_ARRAY);
+
+    /// @brief Source rects of one state's frames, interleaved with the rects of their shadows.
+    struct FrameSpan {
+        const SDL_FRect* rects = nullptr;
+        int count = 0;
+
+        /// @brief Returns the rect of a frame, wrapping past the last one.
+        constexpr const SDL_FRect& operator()(int frame, bool shadow = false) const {
+            return rects[(frame % count) * 2 + shadow];
+        }
+    };
+
+    /// @brief A FrameTable with its size erased, so tables of different characters share a type.
+    template<class T>
+    struct FrameTableRef {
+        const SDL_FRect* rects = nullptr;
+        const int* first = nullptr;
+        const int* count = nullptr;
+
+        constexpr FrameSpan operator[](const T& s) const {
+            return {rects + first[static_cast<int>(s)] * 2, count[static_cast<int>(s)]};
+        }
+    };
+
+    /// @brief Returns the number of rects a FrameTable needs for a sprite table.
+    /// States without frames still get one, so lookups never divide by zero.
+    template<size_t SIZE>
+    constexpr size_t frameTableSize(const std::array<SpriteInfo, SIZE>& sprite) {
+        size_t frames = 0;
+        for (const SpriteInfo& info : sprite)
+            frames += info.frameCount > 0 ? info.frameCount : 1;
+        return frames;
+    }
+
+    /**
+     * @class FrameTable
+     * @brief Source rects of every frame of a sprite table, computed at compile time.
+     *
+     * Frames sit NEXT_FRAME_OFFSET apart in the sheet and their shadows SHADOW_OFFSET below them;
+     * each rect is shrunk by a border to keep the neighbouring cells out of filtering.
+     */
+    template<class T, size_t SIZE, size_t FRAMES>
+    class FrameTable {
+    public:
+        constexpr FrameTable(const std::array<SpriteInfo, SIZE>& sprite, const int border) {
+            int next = 0;
+            for (size_t i = 0; i < SIZE; ++i) {
+                const SpriteInfo& info = sprite[i];
+                first[i] = next;
+                count[i] = info.frameCount > 0 ? info.frameCount : 1;
+                for (int frame = 0; frame < count[i]; ++frame, ++next) {
+                    const float x = info.x + frame * (NEXT_FRAME_OFFSET + info.w) + border;
+                    const float w = info.w - 2 * border, h = info.h - 2 * border;
+                    rects[next * 2] = {x, info.y + border, w, h};
+                    rects[next * 2 + 1] = {x, info.y + SHADOW_OFFSET + info.h + border, w, h};
+                }
+            }
+        }
+
+        constexpr FrameSpan operator[](const T& s) const {
+            return {rects.data() + first[static_cast<int>(s)] * 2, count[static_cast<int>(s)]};
+        }
+
+        constexpr operator FrameTableRef<T>() const {
+            return {rects.data(), first.data(), count.data()};
+        }
+
+    private:
+        std::array<SDL_FRect, FRAMES * 2> rects{};
+        std::array<int, SIZE> first{};
+        std::array<int, SIZE> count{};
+    };
+
+    static constexpr FrameTable<State, CHARACTER_SPRITE_SIZE, frameTableSize(SUBZERO_SPRITE_ARRAY)>
+        SUBZERO_FRAMES(SUBZERO_SPRITE_ARRAY, 1);
+    static constexpr FrameTable<State, CHARACTER_SPRITE_SIZE, frameTableSize(LIU_KANG_SPRITE_ARRAY)>
+        LIU_KANG_FRAMES(LIU_KANG_SPRITE_ARRAY, 1);
+    static constexpr FrameTable<SpecialAttacks, SPECIAL_ATTACK_SPRITE_SIZE, frameTableSize(SUBZERO_SPECIAL_SPRITE_ARRAY)>
+        SUBZERO_SPECIAL_ATTACK_FRAMES(SUBZERO_SPECIAL_SPRITE_ARRAY, 1);
+    static constexpr FrameTable<SpecialAttacks, SPECIAL_ATTACK_SPRITE_SIZE, frameTableSize(LIU_KANG_SPECIAL_SPRITE_ARRAY)>
+        LIU_SPECIAL_ATTACK_FRAMES(LIU_KANG_SPECIAL_SPRITE_ARRAY, 1);
+    static constexpr FrameTable<CharacterType, WIN_SPRITE_BY_CHARACTER_SIZE, frameTableSize(WIN_SPRITE_BY_CHARACTER_ARRAY)>
+        WIN_FRAMES(WIN_SPRITE_BY_CHARACTER_ARRAY, 2);
+
+    /// @brief Axis-aligned box in pixels, relative to a fighter's position while facing right.
+    struct HitBox {
+        float x = 0, y = 0, w = 0, h = 0;
+
+        constexpr bool empty() const { return w <= 0 || h <= 0; }
+
+        /// @brief Moves the box to a fighter's position, mirroring it if the fighter faces left.
+        constexpr HitBox placed(float posX, float posY, bool facingLeft) const {
+            return {posX + (facingLeft ? -(x + w) : x), posY + y, w, h};
+        }
+
+        /// @brief Whether two placed boxes intersect; touching edges don't count.
+        constexpr bool overlaps(const HitBox& o) const {
+            return (x < o.x + o.w) & (o.x < x + w) & (y < o.y + o.h) & (o.y < y + h);
+        }
+    };
+
+    /// @brief Hit box of one animation frame.
+    struct FrameBoxes {
+        HitBox hit;  // Empty on frames that don't strike
+    };
+
+    /// @brief Where an attack state strikes, and whether on every frame or only its strike frame.
+    /// The strike frame is a third into the animation.
+    struct AttackBox {
+        State state;
+        HitBox hit;
+        bool everyFrame;
+    };
+
+    static constexpr HitBox STANDING_HURT_BOX = {-25, -67.5f, 50, 135};
+    static constexpr HitBox CROUCHING_HURT_BOX = {-25, -135, 50, 135};
+
+    /// @brief A fighter's hurt box, where its Box2D body is: lowered while PlayerState::isCrouching.
+    constexpr const HitBox& hurtBox(bool crouching) {
+        return crouching ? CROUCHING_HURT_BOX : STANDING_HURT_BOX;
+    }
+
+    static constexpr AttackBox ATTACK_BOXES[] = {
+        {State::LOW_PUNCH,          {0,  20, 70, 40}, false},
+        {State::HIGH_PUNCH,         {0,  20, 70, 40}, false},
+        {State::LOW_KICK,           {0, -20, 95, 40}, false},
+        {State::HIGH_KICK,          {0, -20, 95, 40}, false},
+        {State::HIGH_SWEEP_KICK,    {0,  20, 95, 40}, false},
+        {State::LOW_SWEEP_KICK,     {0, -60, 85, 40}, false},
+        {State::CROUCH_KICK,        {0, -60, 85, 40}, false},
+        {State::UPPERCUT,           {0,  20, 50, 40}, false},
+        // Airborne attacks stay out for the whole jump
+        {State::JUMP_PUNCH,         {0,  20, 70, 40}, true},
+        {State::FORWARD_JUMP_PUNCH, {0,  20, 70, 40}, true},
+        {State::JUMP_LOW_KICK,      {0,  20, 70, 40}, true},
+        {State::JUMP_HIGH_KICK,     {0,  20, 70, 40}, true},
+    };
+
+    /// @brief A FrameBoxTable with its size erased, so tables of different characters share a type.
+    struct FrameBoxTableRef {
+        const FrameBoxes* boxes = nullptr;
+        const int* first = nullptr;
+        const int* count = nullptr;
+
+        /// @brief Returns the boxes of a frame, wrapping past the last one.
+        constexpr const FrameBoxes& operator()(State state, int frame) const {
+            const int s = static_cast<int>(state);
+            return boxes[first[s] + frame % count[s]];
+        }
+    };
+
+    /**
+     * @class FrameBoxTable
+     * @brief Hit boxes of every frame of a fighter's states, computed at compile time.
+     *
+     * Laid out like FrameTable, so the boxes of a frame are found the same way as its rects.
+     */
+    template<size_t SIZE, size_t FRAMES>
+    class FrameBoxTable {
+    public:
+        constexpr explicit FrameBoxTable(const std::array<SpriteInfo, SIZE>& sprite) {
+            int next = 0;
+            for (size_t i = 0; i < SIZE; ++i) {
+                first[i] = next;
+                count[i] = sprite[i].frameCount > 0 ? sprite[i].frameCount : 1;
+
+                const AttackBox* attack = nullptr;
+                for (const AttackBox& a : ATTACK_BOXES)
+                    if (static_cast<size_t>(a.state) == i)
+                        attack = &a;
+
+                for (int frame = 0; frame < count[i]; ++frame, ++next) {
+                    if (attack && (attack->everyFrame || frame == sprite[i].frameCount / 3))
+                        boxes[next].hit = attack->hit;
+                }
+            }
+        }
+
+        constexpr operator FrameBoxTableRef() const {
+            return {boxes.data(), first.data(), count.data()};
+        }
+
+    private:
+        std::array<FrameBoxes, FRAMES> boxes{};
+        std::array<int, SIZE> first{};
+        std::array<int, SIZE> count{};
+    };
+
+    static constexpr FrameBoxTable<CHARACTER_SPRITE_SIZE, frameTableSize(SUBZERO_SPRITE_ARRAY)>
+        SUBZERO_FRAME_BOXES(SUBZERO_SPRITE_ARRAY);
+    static constexpr FrameBoxTable<CHARACTER_SPRITE_SIZE, frameTableSize(LIU_KANG_SPRITE_ARRAY)>
+        LIU_KANG_FRAME_BOXES(LIU_KANG_SPRITE_ARRAY);
 };
@@ -1,9 +1,27 @@
 #include <iostream>
 #include <cassert>
+#include <string>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include <vector>
 #include "bagel.h"
 using namespace std;
 using namespace bagel;
 
+struct TestPosition { float x = 0, y = 0; };
+struct TestVelocity { float vx = 0, vy = 0; };
+struct TestHealth { float hp = 100; };
+struct TestArmor { int value = 0; };
+struct TestLifetime { int frames = 0; };
+struct TestTracked { int value = 0; static constexpr bool TrackChanges = true; };
+
+namespace bagel {
+	template <> struct Storage<TestLifetime> { using type = PackedStorage<TestLifetime>; };
+	template <> struct Storage<TestHealth> { using type = ArchetypeStorage<TestHealth>; };
+	template <> struct Storage<TestArmor> { using type = ArchetypeStorage<TestArmor>; };
+}
+
 void test1() {
 	ent_type e0 = World::createEntity();
 	assert(e0.id == 0 && "First id is not 0");
@@ -18,7 +36,413 @@ void test1() {
 	cout << "Test 1 passed\n";
 }
 
+void test2() {
+	ent_type e0 = World::createEntity();
+	ent_type e1 = World::createEntity();
+	World::addComponents(e0, TestPosition{}, TestVelocity{});
+	World::addComponent(e1, TestPosition{});
+
+	View<TestPosition,TestVelocity> view;
+	assert(view.size() == 1 && view[0].entity().id == e0.id && "View did not pick up existing match");
+
+	World::addComponent(e1, TestVelocity{});
+	assert(view.size() == 2 && "View not updated on addComponent");
+
+	World::delComponent<TestVelocity>(e0);
+	assert(view.size() == 1 && view[0].entity().id == e1.id && "View not updated on delComponent");
+
+	World::destroyEntity(e1);
+	assert(view.size() == 0 && "View not updated on destroyEntity");
+
+	World::destroyEntity(e0);
+	cout << "Test 2 passed\n";
+}
+
+void test3() {
+	ent_type e0 = World::createEntity();
+	ent_type e1 = World::createEntity();
+	World::addComponents(e0, TestHealth{50}, TestArmor{3});
+	World::addComponent(e1, TestHealth{75});
+	World::addComponent(e1, TestArmor{7});
+	assert(World::getComponent<TestHealth>(e0).hp == 50 && "Component lost moving between archetypes");
+
+	int visited = 0;
+	View<TestHealth,TestArmor>().each([&](ent_type, TestHealth& h, TestArmor& a) {
+		h.hp += static_cast<float>(a.value);
+		++visited;
+	});
+	assert(visited == 2 && "Chunk iteration missed an entity");
+
+	World::delComponent<TestArmor>(e0);
+	assert(World::getComponent<TestHealth>(e0).hp == 53 && "Component lost after delComponent");
+	assert(World::getComponent<TestHealth>(e1).hp == 82 && "Swapped row not relocated");
+	assert(World::getComponent<TestArmor>(e1).value == 7 && "Swapped row not relocated");
+
+	World::destroyEntity(e1);
+	World::destroyEntity(e0);
+	cout << "Test 3 passed\n";
+}
+
+void test4() {
+	for (int i = 0; i < 100; ++i) {
+		ent_type e = World::createEntity();
+		World::addComponents(e, TestLifetime{i}, TestHealth{}, TestPosition{});
+		World::destroyEntity(e);
+	}
+	assert(World::storage<TestLifetime>().size() == 0 && "Packed slots not released on destroyEntity");
+	cout << "Test 4 passed\n";
+}
+
+void test5() {
+	ent_type stale = World::createEntity();
+	World::destroyEntity(stale);
+	ent_type fresh = World::createEntity();
+	assert(fresh.id == stale.id && "Id not recycled");
+	assert(!World::alive(stale) && World::alive(fresh) && "Recycled id not detected as stale");
+
+	World::destroyEntity(stale);
+	assert(World::alive(fresh) && "Destroying a stale handle killed its successor");
+
+	void* data = fresh.toUserData();
+	ent_type back = ent_type::fromUserData(data);
+	assert(data != nullptr && back.id == fresh.id && back.version == fresh.version && "User data round trip failed");
+
+	World::destroyEntity(fresh);
+	cout << "Test 5 passed\n";
+}
+
+template <class A>
+void testBag() {
+	DynamicBag<std::string,2,A> bag;
+	for (int i = 0; i < 100; ++i)
+		bag.push(std::string(32, static_cast<char>('a' + i%26)));
+	bag.ensure(1000);
+	for (int i = 0; i < 100; ++i)
+		assert(bag[i] == std::string(32, static_cast<char>('a' + i%26)) && "Bag growth corrupted element");
+}
+
+void test6() {
+	testBag<HeapAllocator>();
+	testBag<ArenaAllocator>();
+	testBag<PoolAllocator>();
+	testBag<HugePageAllocator>();
+	cout << "Test 6 passed\n";
+}
+
+void test7() {
+	ent_type outer = World::createEntity();
+	World::addComponents(outer, TestPosition{1, 1}, TestHealth{10});
+	{
+		World match;
+		World::Scope scope(match);
+		ent_type e = World::createEntity();
+		assert(e.id == 0 && "New world does not start from id 0");
+		World::addComponents(e, TestPosition{2, 2}, TestHealth{20});
+		assert(View<TestPosition>().size() == 1 && "View saw entities of another world");
+		assert(World::getComponent<TestHealth>(e).hp == 20 && "Component read from another world");
+	}
+	assert(World::alive(outer) && "Scope did not restore the previous world");
+	assert(World::getComponent<TestPosition>(outer).x == 1 && "Default world corrupted by another world");
+	assert(World::getComponent<TestHealth>(outer).hp == 10 && "Default world corrupted by another world");
+
+	World::destroyEntity(outer);
+	cout << "Test 7 passed\n";
+}
+
+void test8() {
+	World match;
+	World::Scope scope(match);
+	ent_type e = World::createEntity();
+	World::addComponents(e, TestPosition{}, TestVelocity{1, 1});
+
+	ThreadPool pool(3);
+	Scheduler scheduler(pool);
+	std::atomic<int> clock{0};
+	int integrated = 0, damped = 0, checked = 0, mainOnly = 0;
+	const auto mainThread = std::this_thread::get_id();
+
+	scheduler.add([&] {
+		for (const ent_type x : View<TestPosition,TestVelocity>())
+			World::getComponent<TestPosition>(x).x += World::getComponent<TestVelocity>(x).vx;
+		integrated = ++clock;
+	}).reads<TestVelocity>().writes<TestPosition>();
+	scheduler.add([&] {
+		World::getComponent<TestVelocity>(e).vx += 1;
+		damped = ++clock;
+	}).writes<TestVelocity>();
+	scheduler.add([&] {
+		assert(World::getComponent<TestPosition>(e).x > 0 && "Reader ran before writer");
+		checked = ++clock;
+	}).reads<TestPosition>();
+	scheduler.add([&] {
+		if (std::this_thread::get_id() == mainThread)
+			++mainOnly;
+	}).onMainThread();
+
+	for (int frame = 0; frame < 50; ++frame) {
+		scheduler.run();
+		assert(integrated < damped && integrated < checked && "Conflicting systems reordered");
+	}
+	assert(mainOnly == 50 && "Main thread system ran on a worker");
+	assert(World::getComponent<TestPosition>(e).x == 50*51/2 && "System skipped a frame");
+
+	World::destroyEntity(e);
+	cout << "Test 8 passed\n";
+}
+
+void test9() {
+	World match;
+	World::Scope scope(match);
+
+	CommandBuffer a, b;
+	ent_type first = a.create();
+	a.addAll(first, TestPosition{1, 1}, TestVelocity{});
+	ent_type spawned{-1};
+	a.call(first, [&](ent_type e) { spawned = e; });
+	ent_type second = b.create();
+	b.add(second, TestPosition{2, 2});
+	b.add(second, std::string(64, 'x'));
+	ent_type merged{-1};
+	b.call(second, [&](ent_type e) { merged = e; });
+	assert(!World::alive(first) && View<TestPosition>().size() == 0 && "Command applied before playback");
+
+	a.merge(b);
+	assert(b.empty() && a.size() == 8 && "Merge lost commands");
+	a.play();
+	assert(View<TestPosition>().size() == 2 && "Merged commands not played");
+	assert(World::alive(spawned) && World::getComponent<TestPosition>(spawned).x == 1 && "Provisional handle not resolved");
+	assert(merged.id != spawned.id && World::getComponent<std::string>(merged) == std::string(64, 'x')
+		&& "Merged handle resolved to the wrong entity");
+
+	// Recorded during playback into the buffer being played
+	CommandBuffer& own = World::commands();
+	ent_type late{-1};
+	own.call([&] { own.call([&] { late = World::createEntity(); }); });
+	World::flush();
+	assert(own.empty() && World::alive(late) && "Command recorded during playback dropped");
+
+	ThreadPool pool(3);
+	Scheduler scheduler(pool);
+	for (int i = 0; i < 8; ++i)
+		scheduler.add([i] {
+			for (const ent_type e : View<TestPosition,TestVelocity>())
+				World::commands().destroy(e);
+			World::commands().add(World::commands().create(), TestLifetime{i});
+		}).reads<TestPosition,TestVelocity>();
+	scheduler.run();
+	assert(!World::alive(spawned) && World::storage<TestLifetime>().size() == 8 && "Worker commands not flushed");
+	// Played back in system order, whichever worker ran each system
+	int order[8];
+	for (const ent_type e : View<TestLifetime>())
+		order[World::getComponent<TestLifetime>(e).frames] = e.id;
+	for (int i = 1; i < 8; ++i)
+		assert(order[i-1] < order[i] && "Commands not played back in system order");
+
+	cout << "Test 9 passed\n";
+}
+
+void test10() {
+	World match;
+	World::Scope scope(match);
+	ent_type e0 = World::createEntity();
+	ent_type e1 = World::createEntity();
+	World::addComponents(e0, TestTracked{}, TestPosition{});
+	World::addComponents(e1, TestTracked{}, TestPosition{});
+
+	View<TestTracked,TestPosition> view;
+	int n = 0;
+	for (ent_type e : view.changedSince<TestTracked>(World::tick())) { (void)e; ++n; }
+	assert(n == 2 && "Added components not stamped");
+
+	World::advance();
+	const tick_type since = World::tick();
+	assert(Entity(e0).read<TestTracked>().value == 0 && "Read returned wrong value");
+	World::getComponent<TestPosition>(e0).x = 1;
+	n = 0;
+	for (ent_type e : view.changedSince<TestTracked>(since)) { (void)e; ++n; }
+	assert(n == 0 && "Read or untracked write stamped a component");
+
+	Entity(e1).get<TestTracked>().value = 5;
+	n = 0;
+	for (ent_type e : view.changedSince<TestTracked>(since)) { assert(e.id == e1.id && "Wrong entity reported changed"); ++n; }
+	assert(n == 1 && Entity(e1).changedSince<TestTracked>(since) && !Entity(e0).changedSince<TestTracked>(since)
+		&& "Write not stamped");
+	cout << "Test 10 passed\n";
+}
+
+void test11() {
+	TripleBuffer<std::vector<int>> buffer;
+	assert(!buffer.update() && buffer.front().empty() && "Nothing published yet");
+
+	constexpr int Frames = 20000;
+	std::thread writer([&] {
+		for (int frame = 1; frame <= Frames; ++frame) {
+			std::vector<int>& v = buffer.back();
+			v.assign(16, frame);
+			buffer.publish();
+		}
+	});
+	int last = 0;
+	while (last < Frames) {
+		if (!buffer.update())
+			continue;
+		const std::vector<int>& v = buffer.front();
+		assert(v.size() == 16 && v.front() == v.back() && "Torn snapshot");
+		assert(v.front() > last && "Snapshot went back in time");
+		last = v.front();
+	}
+	writer.join();
+	assert(!buffer.update() && "Stale snapshot reported as new");
+	cout << "Test 11 passed\n";
+}
+
+void test12() {
+	for (const int workers : {0, 3}) {
+		ThreadPool pool(workers);
+		std::vector<std::atomic<int>> hits(1000);
+		std::atomic<int> badWorker{0};
+		struct Loop { std::vector<std::atomic<int>>* hits; std::atomic<int>* badWorker; int workers; } loop{&hits, &badWorker, workers};
+		ParallelFor pf;
+		pf.start(pool, [](int begin, int end, int worker, void* context) {
+			Loop& l = *static_cast<Loop*>(context);
+			if (worker < 0 || worker > l.workers)
+				l.badWorker->fetch_add(1);
+			for (int i = begin; i < end; ++i)
+				(*l.hits)[i].fetch_add(1);
+		}, &loop, 1000, 10);
+		pf.wait();
+		for (const std::atomic<int>& h : hits)
+			assert(h.load() == 1 && "Index not visited exactly once");
+		assert(badWorker.load() == 0 && "Worker index out of range");
+	}
+	cout << "Test 12 passed\n";
+}
+
+void test13() {
+	World world;
+	World::Scope scope(world);
+
+	World::destroyEntity(World::createEntity());
+	const ent_type recycled = World::createEntity();
+	assert(recycled.id == 0 && recycled.version == 2 && "Id not recycled");
+	World::addComponent(recycled, TestPosition{});
+
+	// The query is built only now, from the entities already in the world
+	const View<TestPosition> view;
+	assert(view.size() == 1 && view[0].entity().version == recycled.version && "Query seeded with a stale version");
+	World::destroyEntity(view[0].entity());
+	assert(!World::alive(recycled) && view.size() == 0 && "Destroy through the view missed");
+	cout << "Test 13 passed\n";
+}
+
+void test14() {
+	// A block freed on another thread goes back on the shared list
+	void* p = PoolAllocator::allocate(100, 16);
+	std::thread([p] { PoolAllocator::deallocate(p, 100, 16); }).join();
+	assert(PoolAllocator::allocate(100, 16) == p && "Block freed on another thread not reused");
+	PoolAllocator::deallocate(p, 100, 16);
+
+	// After a reset the arena hands out the same memory again
+	ArenaAllocator::reset();
+	void* first = ArenaAllocator::allocate(64, 64);
+	ArenaAllocator::allocate(Params.ArenaBlockSize, 16); // Spills into a second block
+	ArenaAllocator::reset();
+	assert(ArenaAllocator::allocate(64, 64) == first && "Arena not rewound");
+	ArenaAllocator::reset();
+	cout << "Test 14 passed\n";
+}
+
+void test15() {
+	World world;
+	World::Scope scope(world);
+	World::addComponents(World::createEntity(), TestPosition{}, TestVelocity{});
+
+	// Threads racing to build the same query all get the one that was published
+	const Query* found[4] = {};
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 4; ++i)
+		threads.emplace_back([&world, &found, i] {
+			World::Scope inner(world);
+			found[i] = &World::query(View<TestPosition,TestVelocity>::mask());
+		});
+	for (std::thread& t : threads)
+		t.join();
+	for (const Query* q : found)
+		assert(q == found[0] && q->size() == 1 && "Query built twice");
+	assert(&World::query(View<TestPosition,TestVelocity>::mask()) == found[0] && "Lookup missed a published query");
+	cout << "Test 15 passed\n";
+}
+
+// Box2D's solver pattern: one task per worker, all but the first spinning until the first
+// is done. Stepped from a busy shared pool, they still finish on a pool of their own.
+void test16() {
+	struct Step {
+		std::atomic<bool>	done{false};
+		std::atomic<int>	ran{0};
+	};
+	struct Context {
+		Step*	step;
+		int		index;
+	};
+	struct Stepper {
+		ThreadPool*			solver;
+		std::atomic<bool>	finished{false};
+	};
+
+	for (const int workers : {1, 3, 7}) {
+		ThreadPool shared(2), solver(workers);
+		for (int i = 0; i < 8; ++i)
+			shared.submit({[](void*) { std::this_thread::sleep_for(std::chrono::milliseconds(2)); }, nullptr});
+
+		Stepper stepper{&solver};
+		shared.submit({[](void* arg) {
+			Stepper& s = *static_cast<Stepper*>(arg);
+			const int tasks = s.solver->workers() + 1;
+			for (int n = 0; n < 200; ++n) {
+				Step step;
+				Context contexts[8];
+				ParallelFor loops[8];
+				for (int i = 0; i < tasks; ++i) {
+					contexts[i] = {&step, i};
+					loops[i].start(*s.solver, [](int, int, int, void* c) {
+						const Context& ctx = *static_cast<Context*>(c);
+						if (ctx.index == 0)
+							ctx.step->done.store(true);
+						else
+							while (!ctx.step->done.load())
+								std::this_thread::yield();
+						ctx.step->ran.fetch_add(1);
+					}, &contexts[i], 1, 1);
+				}
+				for (int i = 0; i < tasks; ++i)
+					loops[i].wait();
+				assert(step.ran.load() == tasks && "Solver task lost");
+			}
+			s.finished.store(true);
+		}, &stepper});
+
+		while (!stepper.finished.load())
+			std::this_thread::yield();
+	}
+	cout << "Test 16 passed\n";
+}
+
 void run_tests()
 {
 	test1();
+	test2();
+	test3();
+	test4();
+	test5();
+	test6();
+	test7();
+	test8();
+	test9();
+	test10();
+	test11();
+	test12();
+	test13();
+	test14();
+	test15();
+	test16();
 }